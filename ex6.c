@@ -1,17 +1,40 @@
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 200809L
+#endif
 #include "ex6.h"
 #include <ctype.h>
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <io.h>
+#endif
 
 # define INT_BUFFER 128
+# define OUT_BUFFER 65536
+# define IN_BUFFER 65536
+# define POOL_FIRST_SLAB 4
+# define POOL_MAX_SLAB 256
+# define BITSET_DENSE_COUNT 48
+# define BITSET_SPARSE_COUNT 32
+# define OWNER_INDEX_MIN 16
 
 // ================================================
-// Basic struct definitions from ex6.h assumed:
+// Core struct definitions (full versions in ex6.h):
 //   PokemonData { int id; char *name; PokemonType TYPE; int hp; int attack; EvolutionStatus CAN_EVOLVE; }
-//   PokemonNode { PokemonData* data; PokemonNode* left, *right; }
-//   OwnerNode   { char* ownerName; PokemonNode* pokedexRoot; OwnerNode *next, *prev; }
-//   OwnerNode* ownerHead;
+//   PokemonNode { const PokemonData* data; PokemonNode *left, *right, *parent;
+//                 int height, size, sumHp, sumAttack; const PokemonData *best; }   (AVL node)
+//   OwnerNode   { char* ownerName; PokemonNode* pokedexRoot; NodePool pool; StorageMode storage;
+//                 uint64_t bits[]; int pokemonCount; ...; OwnerNode *next, *prev; }
+//   OwnerNode* ownerHead;  OwnerIndex ownerIndex;  SpeciesHolders speciesIndex[];
 //   const PokemonData pokedex[];
 // ================================================
 
@@ -19,6 +42,16 @@
 // 1) Safe integer reading
 // --------------------------------------------------------------
 
+uint64_t nowNs(void) {
+#if defined(_WIN32)
+    return (uint64_t)clock() * (1000000000u / CLOCKS_PER_SEC);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
 void trimWhitespace(char *str)
 {
     // Remove leading spaces/tabs/\r
@@ -47,7 +80,7 @@ char *myStrdup(const char *src)
     if (!src)
         return NULL;
     size_t len = strlen(src);
-    char *dest = (char *)malloc(len + 1);
+    char *dest = (char *)exMalloc(len + 1, MEM_NAMES);
     if (!dest)
     {
         printf("Memory allocation failed in myStrdup.\n");
@@ -57,9 +90,86 @@ char *myStrdup(const char *src)
     return dest;
 }
 
+// --------------------------------------------------------------
+// Buffered input: stdin is read in big chunks and split into lines in place
+// --------------------------------------------------------------
+static struct {
+    char *data;  // grows only if a single line is longer than the buffer
+    size_t cap;
+    size_t pos;  // first unread byte
+    size_t len;  // end of valid bytes
+} inBuf;
+
+//move the unread tail to the front and read more; returns bytes read (0 = EOF/error)
+static size_t inFill(void) {
+    if (inBuf.pos > 0) {
+        memmove(inBuf.data, inBuf.data + inBuf.pos, inBuf.len - inBuf.pos);
+        inBuf.len -= inBuf.pos;
+        inBuf.pos = 0;
+    }
+    if (inBuf.len + 1 >= inBuf.cap) {
+        size_t cap = inBuf.cap ? inBuf.cap * 2 : IN_BUFFER;
+        char *grown = (char *)exRealloc(inBuf.data, cap, MEM_DATA);
+        if (!grown) {
+            printf("Memory allocation failed.\n");
+            return 0;
+        }
+        inBuf.data = grown;
+        inBuf.cap = cap;
+    }
+    //keep one byte spare for the NUL of an unterminated last line
+    size_t room = inBuf.cap - inBuf.len - 1;
+    //time blocked on input is kept out of the action latencies
+    uint64_t waitStart = nowNs();
+#if defined(_WIN32)
+    size_t n = fread(inBuf.data + inBuf.len, 1, room, stdin);
+    opStats.inputWaitNs += nowNs() - waitStart;
+    if (n == 0)
+        clearerr(stdin);
+#else
+    ssize_t n;
+    do {
+        n = read(STDIN_FILENO, inBuf.data + inBuf.len, room);
+    } while (n < 0 && errno == EINTR);
+    opStats.inputWaitNs += nowNs() - waitStart;
+    if (n <= 0)
+        return 0;
+#endif
+    inBuf.len += (size_t)n;
+    return (size_t)n;
+}
+
+char *readLineSlice(size_t *len) {
+    for (;;) {
+        char *start = inBuf.data + inBuf.pos;
+        char *nl = inBuf.len > inBuf.pos ? (char *)memchr(start, '\n', inBuf.len - inBuf.pos) : NULL;
+        if (nl != NULL) {
+            *nl = '\0';
+            *len = (size_t)(nl - start);
+            inBuf.pos = (size_t)(nl - inBuf.data) + 1;
+            return start;
+        }
+        if (inFill() == 0) {
+            if (inBuf.pos == inBuf.len)
+                return NULL;
+            //last line has no newline: hand out what is left
+            start = inBuf.data + inBuf.pos;
+            *len = inBuf.len - inBuf.pos;
+            inBuf.data[inBuf.len] = '\0';
+            inBuf.pos = inBuf.len;
+            return start;
+        }
+    }
+}
+
+void releaseInput(void) {
+    exFree(inBuf.data);
+    inBuf.data = NULL;
+    inBuf.cap = inBuf.pos = inBuf.len = 0;
+}
+
 int readIntSafe(const char *prompt)
 {
-    char buffer[INT_BUFFER];
     int value;
     int success = 0;
 
@@ -68,20 +178,17 @@ int readIntSafe(const char *prompt)
         printf("%s", prompt);
 
         // If we fail to read, treat it as invalid
-        if (!fgets(buffer, sizeof(buffer), stdin))
+        size_t len;
+        char *line = readLineSlice(&len);
+        if (!line)
         {
             printf("Invalid input.\n");
-            clearerr(stdin);
             continue;
         }
 
-        // 1) Strip any trailing \r or \n
-        //    so "123\r\n" becomes "123"
-        size_t len = strlen(buffer);
-        if (len > 0 && (buffer[len - 1] == '\n' || buffer[len - 1] == '\r'))
-            buffer[--len] = '\0';
-        if (len > 0 && (buffer[len - 1] == '\r' || buffer[len - 1] == '\n'))
-            buffer[--len] = '\0';
+        // 1) Strip a trailing \r so "123\r\n" becomes "123"
+        if (len > 0 && line[len - 1] == '\r')
+            line[--len] = '\0';
 
         // 2) Check if empty after stripping
         if (len == 0)
@@ -90,9 +197,9 @@ int readIntSafe(const char *prompt)
             continue;
         }
 
-        // 3) Attempt to parse integer with strtol
+        // 3) Attempt to parse integer with strtol, straight from the input buffer
         char *endptr;
-        value = (int)strtol(buffer, &endptr, 10);
+        value = (int)strtol(line, &endptr, 10);
 
         // If endptr didn't point to the end => leftover chars => invalid
         // or if buffer was something non-numeric
@@ -112,43 +219,52 @@ int readIntSafe(const char *prompt)
 // --------------------------------------------------------------
 // 2) Utility: Get type name from enum
 // --------------------------------------------------------------
+static const char *const typeNames[] = {
+    "GRASS", "FIRE", "WATER", "BUG", "NORMAL", "POISON", "ELECTRIC", "GROUND",
+    "FAIRY", "FIGHTING", "PSYCHIC", "ROCK", "GHOST", "DRAGON", "ICE"
+};
+
 const char *getTypeName(PokemonType type)
 {
-    switch (type)
-    {
-    case GRASS:
-        return "GRASS";
-    case FIRE:
-        return "FIRE";
-    case WATER:
-        return "WATER";
-    case BUG:
-        return "BUG";
-    case NORMAL:
-        return "NORMAL";
-    case POISON:
-        return "POISON";
-    case ELECTRIC:
-        return "ELECTRIC";
-    case GROUND:
-        return "GROUND";
-    case FAIRY:
-        return "FAIRY";
-    case FIGHTING:
-        return "FIGHTING";
-    case PSYCHIC:
-        return "PSYCHIC";
-    case ROCK:
-        return "ROCK";
-    case GHOST:
-        return "GHOST";
-    case DRAGON:
-        return "DRAGON";
-    case ICE:
-        return "ICE";
-    default:
-        return "UNKNOWN";
+    if ((unsigned)type < sizeof(typeNames) / sizeof(typeNames[0]))
+        return typeNames[type];
+    return "UNKNOWN";
+}
+
+int parseTypeName(const char *name) {
+    for (int t = 0; t < TYPE_COUNT; t++) {
+        const char *a = typeNames[t], *b = name;
+        while (*a != '\0' && toupper((unsigned char)*b) == *a) {
+            a++;
+            b++;
+        }
+        if (*a == '\0' && *b == '\0')
+            return t;
+    }
+    return -1;
+}
+
+// typeSpeciesIds[typeStart[t] .. typeStart[t+1]) = catalog IDs of type t, ascending
+static int typeSpeciesIds[POKEDEX_SIZE];
+static int typeStart[TYPE_COUNT + 1];
+static int typeTableReady = 0;
+
+const int *typeSpecies(PokemonType type, int *count) {
+    if (!typeTableReady) {
+        //counting sort of the catalog by type, so IDs stay ascending within a type
+        int next[TYPE_COUNT];
+        for (int i = 0; i < POKEDEX_SIZE; i++)
+            typeStart[pokedex[i].TYPE + 1]++;
+        for (int t = 0; t < TYPE_COUNT; t++) {
+            typeStart[t + 1] += typeStart[t];
+            next[t] = typeStart[t];
+        }
+        for (int i = 0; i < POKEDEX_SIZE; i++)
+            typeSpeciesIds[next[pokedex[i].TYPE]++] = i + 1;
+        typeTableReady = 1;
     }
+    *count = typeStart[type + 1] - typeStart[type];
+    return &typeSpeciesIds[typeStart[type]];
 }
 
 // --------------------------------------------------------------
@@ -156,38 +272,113 @@ const char *getTypeName(PokemonType type)
 // --------------------------------------------------------------
 char *getDynamicInput()
 {
-    char *input = NULL;
-    size_t size = 0, capacity = 1;
-    input = (char *)malloc(capacity);
+    size_t len = 0;
+    const char *line = readLineSlice(&len);
+    if (!line)
+        line = "";
+
+    // Trim leading/trailing whitespace or carriage returns on the slice, then copy once
+    while (*line == ' ' || *line == '\t' || *line == '\r') {
+        line++;
+        len--;
+    }
+    while (len > 0 && (line[len - 1] == ' ' || line[len - 1] == '\t' || line[len - 1] == '\r'))
+        len--;
+
+    char *input = (char *)exMalloc(len + 1, MEM_NAMES);
     if (!input)
     {
         printf("Memory allocation failed.\n");
         return NULL;
     }
+    memcpy(input, line, len);
+    input[len] = '\0';
+    return input;
+}
 
-    int c;
-    while ((c = getchar()) != '\n' && c != EOF)
-    {
-        if (size + 1 >= capacity)
-        {
-            capacity *= 2;
-            char *temp = (char *)realloc(input, capacity);
-            if (!temp)
-            {
-                printf("Memory reallocation failed.\n");
-                free(input);
-                return NULL;
-            }
-            input = temp;
+// --------------------------------------------------------------
+// Buffered output: display paths format into one buffer and write() it in one go
+// --------------------------------------------------------------
+static struct {
+    char data[OUT_BUFFER];
+    size_t len;
+    int depth; // nesting of outBeginBatch calls
+} outBuf;
+
+void outFlush(void) {
+    //a reply must never reach the client before the journal records it acknowledges
+    if (outBuf.len > 0)
+        journalCommit();
+    size_t done = 0;
+    while (done < outBuf.len) {
+#if defined(_WIN32)
+        size_t n = fwrite(outBuf.data + done, 1, outBuf.len - done, stdout);
+        if (n == 0)
+            break;
+#else
+        ssize_t n = write(STDOUT_FILENO, outBuf.data + done, outBuf.len - done);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+#endif
+        done += (size_t)n;
+    }
+#if defined(_WIN32)
+    fflush(stdout);
+#endif
+    outBuf.len = 0;
+}
+
+void outBeginBatch(void) {
+    //anything printf'd so far must reach the fd before our bytes do
+    if (outBuf.depth++ == 0)
+        fflush(stdout);
+}
+
+void outEndBatch(void) {
+    if (--outBuf.depth == 0)
+        outFlush();
+}
+
+void outPutChars(const char *s, size_t n) {
+    if (outBuf.len + n > OUT_BUFFER) {
+        outFlush();
+        if (n > OUT_BUFFER) {
+            //too big to stage: send it straight through
+            memcpy(outBuf.data, s, OUT_BUFFER);
+            outBuf.len = OUT_BUFFER;
+            outFlush();
+            outPutChars(s + OUT_BUFFER, n - OUT_BUFFER);
+            return;
         }
-        input[size++] = (char)c;
     }
-    input[size] = '\0';
+    memcpy(outBuf.data + outBuf.len, s, n);
+    outBuf.len += n;
+}
 
-    // Trim any leading/trailing whitespace or carriage returns
-    trimWhitespace(input);
+void outPutStr(const char *s) {
+    outPutChars(s, strlen(s));
+}
 
-    return input;
+void outPutInt(int value) {
+    char digits[12];
+    int i = sizeof(digits);
+    //unsigned math so INT_MIN doesn't overflow
+    unsigned int u = value < 0 ? 0u - (unsigned int)value : (unsigned int)value;
+    do {
+        digits[--i] = (char)('0' + u % 10);
+        u /= 10;
+    } while (u != 0);
+    if (value < 0)
+        digits[--i] = '-';
+    outPutChars(digits + i, sizeof(digits) - i);
+}
+
+void outPutTenths(int tenths) {
+    outPutInt(tenths / 10);
+    outPutChars(".", 1);
+    outPutInt(tenths % 10);
 }
 
 // Function to print a single Pokemon node
@@ -195,84 +386,210 @@ void printPokemonNode(PokemonNode *node)
 {
     if (!node)
         return;
-    printf("ID: %d, Name: %s, Type: %s, HP: %d, Attack: %d, Can Evolve: %s\n",
-           node->data->id,
-           node->data->name,
-           getTypeName(node->data->TYPE),
-           node->data->hp,
-           node->data->attack,
-           (node->data->CAN_EVOLVE == CAN_EVOLVE) ? "Yes" : "No");
+    outBeginBatch();
+    outPutChars("ID: ", 4);
+    outPutInt(node->data->id);
+    outPutChars(", Name: ", 8);
+    outPutStr(node->data->name);
+    outPutChars(", Type: ", 8);
+    outPutStr(getTypeName(node->data->TYPE));
+    outPutChars(", HP: ", 6);
+    outPutInt(node->data->hp);
+    outPutChars(", Attack: ", 10);
+    outPutInt(node->data->attack);
+    if (node->data->CAN_EVOLVE == CAN_EVOLVE)
+        outPutChars(", Can Evolve: Yes\n", 18);
+    else
+        outPutChars(", Can Evolve: No\n", 17);
+    outEndBatch();
 }
 
 void BFSGeneric(PokemonNode *root, VisitNodeFunc visit) {
     if (root == NULL) {
-        printf("Pokedex is empty.\n");
+        outBeginBatch();
+        outPutStr("Pokedex is empty.\n");
+        outEndBatch();
         return;
     }
-    Queue *q = createQueue();
-    enqueue(q, root);
-    while (!isEmpty(q)) {
-        PokemonNode *cur = dequeue(q);
+    Queue q;
+    initQueue(&q);
+    enqueue(&q, root);
+    while (!isEmpty(&q)) {
+        PokemonNode *cur = dequeue(&q);
         visit(cur);
         if(cur->left != NULL) {
-            enqueue(q, cur->left);
+            enqueue(&q, cur->left);
         }
         if(cur->right != NULL) {
-            enqueue(q, cur->right);
+            enqueue(&q, cur->right);
         }
     }
-    free(q);
+    destroyQueue(&q);
 }
-void preOrderGeneric(PokemonNode *root, VisitNodeFunc visit) {
-    if (root == NULL)
-        return;
-    visit(root);
-    preOrderGeneric(root->left, visit);
-    preOrderGeneric(root->right, visit);
+static void initStack(NodeStack *st) {
+    st->items = st->inlineItems;
+    st->count = 0;
+    st->capacity = STACK_INLINE_CAP;
 }
-void inOrderGeneric(PokemonNode *root, VisitNodeFunc visit) {
-    if (root == NULL)
-        return;
-    inOrderGeneric(root->left, visit);
-    visit(root);
-    inOrderGeneric(root->right, visit);
+
+static void destroyStack(NodeStack *st) {
+    if (st->items != st->inlineItems)
+        exFree(st->items);
 }
-void postOrderGeneric(PokemonNode *root, VisitNodeFunc visit) {
+
+static int pushNode(NodeStack *st, PokemonNode *node) {
+    if (st->count == st->capacity) {
+        PokemonNode **grown = (PokemonNode **)exMalloc(2 * st->capacity * sizeof(PokemonNode *), MEM_QUEUES);
+        if (!grown) {
+            printf("Memory allocation failed.\n");
+            return 0;
+        }
+        memcpy(grown, st->items, st->count * sizeof(PokemonNode *));
+        if (st->items != st->inlineItems)
+            exFree(st->items);
+        st->items = grown;
+        st->capacity *= 2;
+    }
+    st->items[st->count++] = node;
+    return 1;
+}
+
+void walkTreeStack(PokemonNode *root, TraversalOrder order, VisitNodeCtxFunc visit, void *ctx) {
     if (root == NULL)
         return;
-    postOrderGeneric(root->left, visit);
-    postOrderGeneric(root->right, visit);
-    visit(root);
+    NodeStack st;
+    initStack(&st);
+    PokemonNode *cur = root;
+    PokemonNode *last = NULL;
+    switch (order) {
+    case ORDER_PRE:
+        pushNode(&st, root);
+        while (st.count > 0) {
+            cur = st.items[--st.count];
+            PokemonNode *left = cur->left, *right = cur->right;
+            visit(cur, ctx);
+            //right first so the left subtree is popped first
+            if (right != NULL && !pushNode(&st, right))
+                break;
+            if (left != NULL && !pushNode(&st, left))
+                break;
+        }
+        break;
+    case ORDER_IN:
+        while (cur != NULL || st.count > 0) {
+            while (cur != NULL) {
+                if (!pushNode(&st, cur))
+                    goto done;
+                cur = cur->left;
+            }
+            cur = st.items[--st.count];
+            PokemonNode *right = cur->right;
+            visit(cur, ctx);
+            cur = right;
+        }
+        break;
+    case ORDER_POST:
+        while (cur != NULL || st.count > 0) {
+            if (cur != NULL) {
+                if (!pushNode(&st, cur))
+                    goto done;
+                cur = cur->left;
+                continue;
+            }
+            PokemonNode *top = st.items[st.count - 1];
+            if (top->right != NULL && last != top->right) {
+                cur = top->right;
+            }
+            else {
+                //only pointers are compared after this, so visit may free top
+                st.count--;
+                last = top;
+                visit(top, ctx);
+            }
+        }
+        break;
+    }
+done:
+    destroyStack(&st);
 }
 
-void initNodeArray(NodeArray *na, int cap) {
-    na->capacity = cap;
-    na->size = 0;
-    na->nodes = (PokemonNode **)malloc(cap * sizeof(PokemonNode*));
-    if (!na->nodes) {
-        printf("Memory allocation failed.\n");
+//reverse the right-chain from..to, visit it backwards, then restore it
+static void visitReversedChain(PokemonNode *from, PokemonNode *to, VisitNodeCtxFunc visit, void *ctx) {
+    PokemonNode *prev = NULL, *cur = from;
+    while (prev != to) {
+        PokemonNode *next = cur->right;
+        cur->right = prev;
+        prev = cur;
+        cur = next;
+    }
+    cur = to;
+    prev = NULL;
+    while (prev != from) {
+        visit(cur, ctx);
+        PokemonNode *next = cur->right;
+        cur->right = prev;
+        prev = cur;
+        cur = next;
     }
 }
 
-void addNode(NodeArray *na, PokemonNode *node) {
-    if (na->size == na->capacity-1) {
-        na->capacity *= 2;
-        //LEAK
-        na->nodes = (PokemonNode **)realloc(na->nodes, na->capacity * sizeof(PokemonNode*));
-        if (!na->nodes) {
-            printf("Memory allocation failed.\n");
+void walkTreeMorris(PokemonNode *root, TraversalOrder order, VisitNodeCtxFunc visit, void *ctx) {
+    //post-order threads through a dummy parent whose left subtree is the tree
+    PokemonNode dummy;
+    PokemonNode *cur = root;
+    if (order == ORDER_POST) {
+        dummy.left = root;
+        dummy.right = NULL;
+        cur = &dummy;
+    }
+    while (cur != NULL) {
+        if (cur->left == NULL) {
+            if (order != ORDER_POST)
+                visit(cur, ctx);
+            cur = cur->right;
+            continue;
+        }
+        PokemonNode *pred = cur->left;
+        while (pred->right != NULL && pred->right != cur)
+            pred = pred->right;
+        if (pred->right == NULL) {
+            //first time here: thread the predecessor back to cur
+            if (order == ORDER_PRE)
+                visit(cur, ctx);
+            pred->right = cur;
+            cur = cur->left;
+        }
+        else {
+            //second time: the left subtree is done, remove the thread
+            if (order == ORDER_POST)
+                visitReversedChain(cur->left, pred, visit, ctx);
+            pred->right = NULL;
+            if (order == ORDER_IN)
+                visit(cur, ctx);
+            cur = cur->right;
         }
     }
-    na->nodes[na->size] = node;
-    na->size++;
 }
 
-void collectAll(PokemonNode *root, NodeArray *na) {
-    if(root == NULL)
-        return;
-    addNode(na, root);
-    collectAll(root->left, na);
-    collectAll(root->right, na);
+typedef struct {
+    VisitNodeFunc visit;
+} PlainVisitor;
+
+static void callPlainVisitor(PokemonNode *node, void *ctx) {
+    ((PlainVisitor *)ctx)->visit(node);
+}
+
+void preOrderGeneric(PokemonNode *root, VisitNodeFunc visit) {
+    PlainVisitor pv = { visit };
+    walkTreeStack(root, ORDER_PRE, callPlainVisitor, &pv);
+}
+void inOrderGeneric(PokemonNode *root, VisitNodeFunc visit) {
+    PlainVisitor pv = { visit };
+    walkTreeStack(root, ORDER_IN, callPlainVisitor, &pv);
+}
+void postOrderGeneric(PokemonNode *root, VisitNodeFunc visit) {
+    PlainVisitor pv = { visit };
+    walkTreeStack(root, ORDER_POST, callPlainVisitor, &pv);
 }
 
 /*int compareByNameNode(const void *a, const void *b) {
@@ -280,23 +597,39 @@ void collectAll(PokemonNode *root, NodeArray *na) {
     return 0;
 }*/
 
+// nameRank[id-1] = position of that species in alphabetical order
+static int nameRank[POKEDEX_SIZE];
+static int nameRanksReady = 0;
+
+static int compareSpeciesByName(const void *a, const void *b) {
+    return strcmp(pokedex[*(const int *)a].name, pokedex[*(const int *)b].name);
+}
+
+void initNameRanks(void) {
+    if (nameRanksReady)
+        return;
+    int order[POKEDEX_SIZE];
+    for (int i = 0; i < POKEDEX_SIZE; i++)
+        order[i] = i;
+    qsort(order, POKEDEX_SIZE, sizeof(int), compareSpeciesByName);
+    for (int r = 0; r < POKEDEX_SIZE; r++)
+        nameRank[order[r]] = r;
+    nameRanksReady = 1;
+}
+
+static void rankVisit(PokemonNode *node, void *ctx) {
+    ((PokemonNode **)ctx)[nameRank[node->data->id - 1]] = node;
+}
+
 void displayAlphabetical(PokemonNode *root) {
-    NodeArray na;
-    initNodeArray(&na, 8);
-    collectAll(root, &na);
-    for(int i = 0; i < na.size-1; i++) {
-        for(int j = i; j < na.size; j++) {
-            if(strcmp(na.nodes[i]->data->name, na.nodes[j]->data->name) > 0) {
-                PokemonNode *temp = na.nodes[i];
-                na.nodes[i] = na.nodes[j];
-                na.nodes[j] = temp;
-            }
-        }
-    }
-    for(int i = 0; i < na.size; i++) {
-        printPokemonNode(na.nodes[i]);
+    //one bucket per species name; filling and scanning them replaces sorting
+    PokemonNode *byRank[POKEDEX_SIZE] = { NULL };
+    initNameRanks();
+    walkTreeMorris(root, ORDER_IN, rankVisit, byRank);
+    for(int r = 0; r < POKEDEX_SIZE; r++) {
+        if(byRank[r] != NULL)
+            printPokemonNode(byRank[r]);
     }
-    free(na.nodes);
 }
 
 // --------------------------------------------------------------
@@ -305,7 +638,7 @@ void displayAlphabetical(PokemonNode *root) {
 
 void displayMenu(OwnerNode *owner)
 {
-    if (!owner->pokedexRoot)
+    if (owner->pokemonCount == 0)
     {
         printf("Pokedex is empty.\n");
         return;
@@ -317,183 +650,354 @@ void displayMenu(OwnerNode *owner)
     printf("3. In-Order\n");
     printf("4. Post-Order\n");
     printf("5. Alphabetical (by name)\n");
+    printf("6. In-Order Page\n");
+    printf("7. ID Range\n");
+    printf("8. By Type\n");
 
     int choice = readIntSafe("Your choice: ");
+    if (choice == 6) {
+        displayPage(owner);
+        return;
+    }
+    if (choice == 7) {
+        displayRange(owner);
+        return;
+    }
+    if (choice == 8) {
+        displayByType(owner);
+        return;
+    }
+    PokemonNode scratch[POKEDEX_SIZE];
+    PokemonNode *root = pokedexView(owner, scratch);
 
+    outBeginBatch();
     switch (choice)
     {
     case 1:
-        BFSGeneric(owner->pokedexRoot, printPokemonNode);
+        BFSGeneric(root, printPokemonNode);
         break;
     case 2:
-        preOrderGeneric(owner->pokedexRoot, printPokemonNode);
+        preOrderGeneric(root, printPokemonNode);
         break;
     case 3:
-        inOrderGeneric(owner->pokedexRoot, printPokemonNode);
+        inOrderGeneric(root, printPokemonNode);
         break;
     case 4:
-        postOrderGeneric(owner->pokedexRoot, printPokemonNode);
+        postOrderGeneric(root, printPokemonNode);
         break;
     case 5:
-        displayAlphabetical(owner->pokedexRoot);
+        displayAlphabetical(root);
         break;
     default:
-        printf("Invalid choice.\n");
+        outPutStr("Invalid choice.\n");
     }
+    outEndBatch();
 }
 
-// --------------------------------------------------------------
-// Sub-menu for existing Pokedex
-// --------------------------------------------------------------
-Queue* createQueue() {
-    //LEAK
-    Queue *q = (Queue *)malloc(sizeof(Queue));
-    if (!q) {
-        printf("Memory allocation failed.\n");
-        return NULL;
+void displayPage(OwnerNode *owner) {
+    int pageSize = readIntSafe("Page size: ");
+    int page = readIntSafe("Page number: ");
+    const PokemonData *entries[POKEDEX_SIZE];
+    int n = pokedexPage(owner, page, pageSize, entries);
+    if (n == 0) {
+        printf("No such page.\n");
+        return;
     }
-    q->head = NULL;
-    q->tail = NULL;
-    return q;
+    int pages = (owner->pokemonCount - 1) / pageSize + 1;
+    outBeginBatch();
+    outPutStr("Page ");
+    outPutInt(page);
+    outPutStr(" of ");
+    outPutInt(pages);
+    outPutStr(":\n");
+    for (int i = 0; i < n; i++) {
+        PokemonNode view = { entries[i], NULL, NULL, NULL, 1, 1, entries[i]->hp, entries[i]->attack, entries[i] };
+        printPokemonNode(&view);
+    }
+    outEndBatch();
 }
 
-void enqueue(Queue *q, PokemonNode *node) {
-    if (!q) {
+//prompt for a type name; -1 (after saying so) if it isn't one
+static int readTypeName(void) {
+    printf("Type (e.g. FIRE): ");
+    char *name = getDynamicInput();
+    int type = name ? parseTypeName(name) : -1;
+    exFree(name);
+    if (type < 0)
+        printf("Unknown type.\n");
+    return type;
+}
+
+void displayByType(OwnerNode *owner) {
+    int type = readTypeName();
+    if (type < 0)
+        return;
+    const PokemonData *entries[POKEDEX_SIZE];
+    int n = pokedexOfType(owner, (PokemonType)type, entries);
+    if (n == 0) {
+        printf("No %s Pokemon.\n", getTypeName((PokemonType)type));
         return;
     }
-    QueueNode *newNode = (QueueNode *)malloc(sizeof(QueueNode));
-    if (!newNode) {
-        printf("Memory allocation failed.\n");
+    outBeginBatch();
+    for (int i = 0; i < n; i++) {
+        PokemonNode view = { entries[i], NULL, NULL, NULL, 1, 1, entries[i]->hp, entries[i]->attack, entries[i] };
+        printPokemonNode(&view);
+    }
+    outPutInt(n);
+    outPutChars(" ", 1);
+    outPutStr(getTypeName((PokemonType)type));
+    outPutStr(" Pokemon.\n");
+    outEndBatch();
+}
+
+static void printTypeHolder(OwnerNode *owner, const PokemonData *p, void *ctx) {
+    (void)ctx;
+    outPutStr(owner->ownerName);
+    outPutStr(": ");
+    outPutStr(p->name);
+    outPutStr(" (ID ");
+    outPutInt(p->id);
+    outPutStr(")\n");
+}
+
+static void printLeader(OwnerNode *owner, const PokemonData *p, void *ctx) {
+    int *place = (int *)ctx;
+    outPutInt(++*place);
+    outPutStr(". ");
+    outPutStr(owner->ownerName);
+    outPutStr(": ");
+    outPutStr(p->name);
+    outPutStr(" (ID ");
+    outPutInt(p->id);
+    outPutStr("), score ");
+    outPutTenths(p->attack * 15 + p->hp * 12);
+    outPutChars("\n", 1);
+}
+
+void showLeaderboard(void) {
+    int k = readIntSafe("How many? ");
+    if (k < 1) {
+        printf("Invalid number.\n");
         return;
     }
-    newNode->data = node;
-    newNode->next = NULL;
+    int place = 0;
+    outBeginBatch();
+    if (forEachTopPokemon(k, printLeader, &place) == 0)
+        outPutStr("No Pokemon yet.\n");
+    outEndBatch();
+}
+
+void showTypeHolders(void) {
+    int type = readTypeName();
+    if (type < 0)
+        return;
+    if (typeHolderCount((PokemonType)type) == 0) {
+        printf("No owner has any %s Pokemon.\n", getTypeName((PokemonType)type));
+        return;
+    }
+    outBeginBatch();
+    int n = forEachOfType((PokemonType)type, printTypeHolder, NULL);
+    outPutInt(n);
+    outPutChars(" ", 1);
+    outPutStr(getTypeName((PokemonType)type));
+    outPutStr(" Pokemon across all owners.\n");
+    outEndBatch();
+}
 
-    if (q->tail == NULL) {
-        q->head = newNode;
-        q->tail = newNode;
+void displayRange(OwnerNode *owner) {
+    int lo = readIntSafe("From ID: ");
+    int hi = readIntSafe("To ID: ");
+    const PokemonData *entries[POKEDEX_SIZE];
+    int n = pokedexRange(owner, lo, hi, entries);
+    if (n == 0) {
+        printf("No Pokemon with IDs %d to %d.\n", lo, hi);
         return;
     }
+    RangeTotals totals = pokedexRangeTotals(owner, lo, hi);
+    outBeginBatch();
+    for (int i = 0; i < n; i++) {
+        PokemonNode view = { entries[i], NULL, NULL, NULL, 1, 1, entries[i]->hp, entries[i]->attack, entries[i] };
+        printPokemonNode(&view);
+    }
+    outPutInt(totals.count);
+    outPutStr(" Pokemon, total HP ");
+    outPutInt(totals.hp);
+    outPutStr(", total Attack ");
+    outPutInt(totals.attack);
+    outPutStr(".\n");
+    outEndBatch();
+}
+
+// --------------------------------------------------------------
+// Sub-menu for existing Pokedex
+// --------------------------------------------------------------
+void initQueue(Queue *q) {
+    q->items = q->inlineItems;
+    q->head = 0;
+    q->count = 0;
+    q->capacity = QUEUE_INLINE_CAP;
+}
+
+void destroyQueue(Queue *q) {
+    if (q->items != q->inlineItems)
+        exFree(q->items);
+    initQueue(q);
+}
 
-    q->tail->next = newNode;
-    q->tail = newNode;
+void enqueue(Queue *q, PokemonNode *node) {
+    if (!q) {
+        return;
+    }
+    if (q->count == q->capacity) {
+        //unwrap into a buffer twice the size
+        PokemonNode **grown = (PokemonNode **)exMalloc(2 * q->capacity * sizeof(PokemonNode *), MEM_QUEUES);
+        if (!grown) {
+            printf("Memory allocation failed.\n");
+            return;
+        }
+        for (int i = 0; i < q->count; i++)
+            grown[i] = q->items[(q->head + i) % q->capacity];
+        if (q->items != q->inlineItems)
+            exFree(q->items);
+        q->items = grown;
+        q->head = 0;
+        q->capacity *= 2;
+    }
+    q->items[(q->head + q->count) % q->capacity] = node;
+    q->count++;
 }
 
 PokemonNode *dequeue(Queue *q) {
-    if (!q || !q->head)
+    if (!q || q->count == 0)
         return NULL;
-    QueueNode *temp = q->head;
-    PokemonNode *result = temp->data;
-    q->head = q->head->next;
-
-    if(q->head == NULL)
-        q->tail = NULL;
-    free(temp);
+    PokemonNode *result = q->items[q->head];
+    q->head = (q->head + 1) % q->capacity;
+    q->count--;
     return result;
 }
 
 int isEmpty(Queue *q) {
-    return (q->head == NULL);
+    return (q->count == 0);
+}
+
+double pokemonScore(const PokemonData *p) {
+    return p->attack * 1.5 + p->hp * 1.2;
+}
+
+int pokemonStronger(const PokemonData *a, const PokemonData *b) {
+    //the score in tenths, so ties are exact
+    int sa = a->attack * 15 + a->hp * 12, sb = b->attack * 15 + b->hp * 12;
+    return sa != sb ? sa > sb : a->id < b->id;
 }
 
-void freeQueue(Queue *q) {
-    while (!isEmpty(q)) {
-        dequeue(q);
+void teamSummary(OwnerNode *owner) {
+    const PokemonData *best = pokedexStrongest(owner);
+    if (best == NULL) {
+        printf("Pokedex is empty.\n");
+        return;
     }
-    free(q);
+    printf("%d Pokemon, team score %.1f, total HP %d, total Attack %d.\n", owner->pokemonCount,
+           pokedexTeamScore(owner), owner->totalHp, owner->totalAttack);
+    printf("Strongest: %s (ID %d), score %.1f.\n", best->name, best->id, pokemonScore(best));
 }
 
 void pokemonFight(OwnerNode *owner) {
-    if (owner->pokedexRoot == NULL) {
+    if (owner->pokemonCount == 0) {
         printf("Pokedex is empty.\n");
         return;
     }
     int first = readIntSafe("Enter ID of the first Pokemon: ");
     int second = readIntSafe("Enter ID of the second Pokemon: ");
-    PokemonNode *a = searchPokemonBFS(owner->pokedexRoot, first);
-    PokemonNode *b = searchPokemonBFS(owner->pokedexRoot, second);
+    const PokemonData *a = pokedexFind(owner, first);
+    const PokemonData *b = pokedexFind(owner, second);
     if(!a || !b) {
         printf("One or both Pokemon IDs not found.\n");
         return;
     }
-    double scoreA = a->data->attack * 1.5 + a->data->hp * 1.2;
-    double scoreB = b->data->attack * 1.5 + b->data->hp * 1.2;
-    printf("Pokemon 1: %s (Score = %.2f)\n", a->data->name, scoreA);
-    printf("Pokemon 2: %s (Score = %.2f)\n", b->data->name, scoreB);
+    double scoreA = pokemonScore(a);
+    double scoreB = pokemonScore(b);
+    printf("Pokemon 1: %s (Score = %.2f)\n", a->name, scoreA);
+    printf("Pokemon 2: %s (Score = %.2f)\n", b->name, scoreB);
     double diff = scoreA - scoreB;
     if(diff < 0.0)
-        printf("%s wins!\n", b->data->name);
+        printf("%s wins!\n", b->name);
     else if(diff > 0.0)
-        printf("%s wins!\n", a->data->name);
+        printf("%s wins!\n", a->name);
     else
         printf("It's a tie!\n");
 }
 
+EvolveResult evolvePokemonByID(OwnerNode *owner, int id) {
+    if(id < 1 || id > POKEDEX_SIZE)
+        return EVOLVE_NOT_FOUND;
+    PokemonNode *node = NULL;
+    int evolutionOwned;
+    if(owner->storage == STORAGE_BITSET) {
+        int bit = id - 1;
+        if(!((owner->bits[bit >> 6] >> (bit & 63)) & 1))
+            return EVOLVE_NOT_FOUND;
+        evolutionOwned = id < POKEDEX_SIZE && ((owner->bits[id >> 6] >> (id & 63)) & 1);
+    }
+    else {
+        //one descent finds id and its in-order successor, which is id+1 if that is owned
+        PokemonNode *next = NULL;
+        node = searchWithSuccessor(owner->pokedexRoot, id, &next);
+        if(node == NULL)
+            return EVOLVE_NOT_FOUND;
+        evolutionOwned = next != NULL && next->data->id == id + 1;
+    }
+    if(!pokedex[id - 1].CAN_EVOLVE)
+        return EVOLVE_CANNOT;
+    //the evolution is already owned: just let the old form go
+    if(evolutionOwned) {
+        pokedexRemove(owner, id);
+        return EVOLVE_RELEASED;
+    }
+    //the index entry for id+1 is the only allocation, so take it before changing anything
+    if(!speciesIndexAdd(owner, id + 1))
+        return EVOLVE_NO_MEMORY;
+    speciesIndexRemove(owner, id);
+    //no ID lies between id and id+1, so the node keeps its place and just changes species
+    if(node != NULL) {
+        relabelPokemonNode(node, &pokedex[id]);
+    }
+    else {
+        owner->bits[(id - 1) >> 6] &= ~((uint64_t)1 << ((id - 1) & 63));
+        owner->bits[id >> 6] |= (uint64_t)1 << (id & 63);
+    }
+    return EVOLVE_DONE;
+}
+
 void evolvePokemon(OwnerNode *owner) {
-    if (owner->pokedexRoot == NULL) {
+    if (owner->pokemonCount == 0) {
         printf("Cannot evolve. Pokedex empty.\n");
         return;
     }
     int choice = readIntSafe("Enter ID of pokemon to evolve: ");
-    if(!searchPokemonBFS(owner->pokedexRoot, choice)) {
+    EvolveResult result = evolvePokemonByID(owner, choice);
+    if(result == EVOLVE_DONE || result == EVOLVE_RELEASED)
+        journalRecord(JOURNAL_EVOLVE, owner->ownerName, NULL, choice);
+    switch(result) {
+    case EVOLVE_NOT_FOUND:
         printf("No Pokemon with ID %d found.\n", choice);
-        return;
-    }
-    if(!pokedex[choice - 1].CAN_EVOLVE) {
+        break;
+    case EVOLVE_CANNOT:
         printf("%s (ID %d) cannot evolve.\n", pokedex[choice - 1].name, pokedex[choice - 1].id);
-        return;
-    }
-
-    //check if the pokemon is in the pokedex already
-    if(searchPokemonBFS(owner->pokedexRoot, choice+1)) {
+        break;
+    case EVOLVE_RELEASED:
         printf("Evolution ID %d (%s) already in the Pokedex. Releasing %s (ID %d).\n", pokedex[choice].id,
                                             pokedex[choice].name, pokedex[choice-1].name,pokedex[choice-1].id);
-        owner->pokedexRoot = removePokemonByID(owner->pokedexRoot, choice);
-        return;
-    }
-
-    //allocate data for the evolution of the pokemon
-    PokemonNode *insert = (PokemonNode*)malloc(sizeof(PokemonNode));
-    if (!insert) {
-        printf("Memory allocation failed.\n");
-        return;
-    }
-
-    insert->data = (PokemonData*)malloc(sizeof(PokemonData));
-    if (!insert->data) {
-        printf("Memory allocation failed.\n");
-        return;
-    }
-
-    //remove the original pokemon and add it's evolution
-    owner->pokedexRoot = removePokemonByID(owner->pokedexRoot, choice);
-    *insert->data = pokedex[(choice)];
-    insert->left = NULL;
-    insert->right = NULL;
-    //if there are no pokemon in the pokedex, allocate memory for the root
-    if(owner->pokedexRoot == NULL) {
-        owner->pokedexRoot = (PokemonNode*)malloc(sizeof(PokemonNode));
-        if (!owner->pokedexRoot) {
-            printf("Memory allocation failed.\n");
-            return;
-        }
-
-        owner->pokedexRoot->data = (PokemonData*)malloc(sizeof(PokemonData));
-        if (!owner->pokedexRoot->data) {
-            printf("Memory allocation failed.\n");
-            return;
-        }
-        owner->pokedexRoot->data = insert->data;
-        owner->pokedexRoot->left = NULL;
-        owner->pokedexRoot->right = NULL;
-        owner->pokedexRoot->parent = NULL;
+        printf("Removing Pokemon %s (ID %d).\n", pokedex[choice - 1].name, pokedex[choice - 1].id);
+        break;
+    case EVOLVE_DONE:
+        printf("Removing Pokemon %s (ID %d).\n", pokedex[choice - 1].name, pokedex[choice - 1].id);
         printf("Pokemon evolved from %s (ID %d) to %s(ID %d).\n",pokedex[choice-1].name,pokedex[choice-1].id,
                                                                         pokedex[choice].name,pokedex[choice].id);
-        return;
+        break;
+    case EVOLVE_NO_MEMORY:
+        //speciesIndexAdd already reported it
+        break;
     }
-    insertPokemonNode(owner->pokedexRoot, insert);
-    printf("Pokemon evolved from %s (ID %d) to %s(ID %d).\n",pokedex[choice-1].name,pokedex[choice-1].id,
-                                                                    pokedex[choice].name,pokedex[choice].id);
 }
 
 PokemonNode *findMinNode(PokemonNode *root) {
@@ -502,547 +1006,3184 @@ PokemonNode *findMinNode(PokemonNode *root) {
     return root;
 }
 
-PokemonNode *insertPokemonNode(PokemonNode *root, PokemonNode *newNode) {
-    if(root->data->id > newNode->data->id) {
-        if(root->left != NULL)
-            return insertPokemonNode(root->left, newNode);
-        newNode->parent = root;
-        root->left = newNode;
-        return root;
-    }
-    if(root->data->id < newNode->data->id) {
-        if(root->right != NULL)
-            return insertPokemonNode(root->right, newNode);
-        newNode->parent = root;
-        root->right = newNode;
-        return root;
-    }
-    printf("Could not insert pokemon.\n");
-    return NULL;
+int nodeHeight(PokemonNode *node) {
+    return node ? node->height : 0;
 }
 
-PokemonNode *searchPokemonBFS(PokemonNode *root, int id) {
-    if(!root)
-        return NULL;
-    if(root->data->id == id)
-        return root;
-    if(root->data->id > id)
-        return searchPokemonBFS(root->left, id);
-    return searchPokemonBFS(root->right, id);
+int nodeSize(PokemonNode *node) {
+    return node ? node->size : 0;
 }
 
-PokemonNode *removeNodeBST(PokemonNode *root, int id) {
-    if(!root)
-        return NULL;
-    if(root->data->id > id)
-        root->left = removeNodeBST(root->left, id);
-    else if(root->data->id < id)
-        root->right = removeNodeBST(root->right, id);
-    else {
-        //if the node has no children
-        if(root->left == NULL && root->right == NULL) {
-            free(root->data);
-            free(root);
-            return NULL;
-        }
-        //if the node has 1 child
-        if(!root->left) {
-            PokemonNode *temp = root->right;
-            temp->parent = root->parent;
-            free(root->data);
-            free(root);
-            return temp;
-        }
-        if(!root->right) {
-            PokemonNode *temp = root->left;
-            temp->parent = root->parent;
-            free(root->data);
-            free(root);
-            return temp;
-        }
-        //if the node has 2 children
-        PokemonNode *successor = findMinNode(root->right);
-        *root->data = *successor->data;
-        root->right = removeNodeBST(root->right, successor->data->id);
-    }
-    return root;
+//recompute height, subtree size and subtree totals from the children
+static void updateNode(PokemonNode *node) {
+    PokemonNode *l = node->left, *r = node->right;
+    int hl = nodeHeight(l);
+    int hr = nodeHeight(r);
+    node->height = (hl > hr ? hl : hr) + 1;
+    node->size = nodeSize(l) + nodeSize(r) + 1;
+    node->sumHp = (l ? l->sumHp : 0) + (r ? r->sumHp : 0) + node->data->hp;
+    node->sumAttack = (l ? l->sumAttack : 0) + (r ? r->sumAttack : 0) + node->data->attack;
+    const PokemonData *best = node->data;
+    if (l && pokemonStronger(l->best, best))
+        best = l->best;
+    if (r && pokemonStronger(r->best, best))
+        best = r->best;
+    node->best = best;
 }
 
-PokemonNode *removePokemonByID(PokemonNode *root, int id) {
-    if (!searchPokemonBFS(root, id)) {
-        printf("No Pokemon with ID %d found.\n", id);
-        return root;
-    }
-    printf("Removing Pokemon %s (ID %d).\n", pokedex[id - 1].name, pokedex[id - 1].id);
-    return removeNodeBST(root, id);
+PokemonNode *rotateLeft(PokemonNode *root) {
+    PokemonNode *pivot = root->right;
+    root->right = pivot->left;
+    if(root->right != NULL)
+        root->right->parent = root;
+    pivot->left = root;
+    pivot->parent = root->parent;
+    root->parent = pivot;
+    updateNode(root);
+    updateNode(pivot);
+    return pivot;
 }
 
-void freePokemon(OwnerNode *owner) {
-    int choice = readIntSafe("Enter Pokemon ID to release: ");
-    owner->pokedexRoot = removePokemonByID(owner->pokedexRoot, choice);
+PokemonNode *rotateRight(PokemonNode *root) {
+    PokemonNode *pivot = root->left;
+    root->left = pivot->right;
+    if(root->left != NULL)
+        root->left->parent = root;
+    pivot->right = root;
+    pivot->parent = root->parent;
+    root->parent = pivot;
+    updateNode(root);
+    updateNode(pivot);
+    return pivot;
 }
 
-void addPokemon(OwnerNode *owner) {
-    int choice = readIntSafe("Enter ID to add: ");
-    if(searchPokemonBFS(owner->pokedexRoot, choice) != NULL) {
-        printf("Pokemon with ID %d is already in the Pokedex. No changes made.\n", choice);
-        return;
+PokemonNode *rebalance(PokemonNode *root) {
+    updateNode(root);
+    int balance = nodeHeight(root->left) - nodeHeight(root->right);
+    if(balance > 1) {
+        //left-right case: straighten the left child first
+        if(nodeHeight(root->left->left) < nodeHeight(root->left->right))
+            root->left = rotateLeft(root->left);
+        return rotateRight(root);
+    }
+    if(balance < -1) {
+        //right-left case: straighten the right child first
+        if(nodeHeight(root->right->right) < nodeHeight(root->right->left))
+            root->right = rotateRight(root->right);
+        return rotateLeft(root);
     }
+    return root;
+}
 
-    PokemonNode *insert = (PokemonNode*)malloc(sizeof(PokemonNode));
-    if (!insert) {
-        printf("Memory allocation failed.\n");
-        return;
+static PokemonNode *insertAVL(PokemonNode *root, PokemonNode *newNode, int *inserted) {
+    if(root == NULL) {
+        newNode->left = NULL;
+        newNode->right = NULL;
+        updateNode(newNode);
+        *inserted = 1;
+        return newNode;
     }
+    opStats.tree[TREE_INSERT].nodesTouched++;
+    if(root->data->id > newNode->data->id) {
+        root->left = insertAVL(root->left, newNode, inserted);
+        root->left->parent = root;
+    }
+    else if(root->data->id < newNode->data->id) {
+        root->right = insertAVL(root->right, newNode, inserted);
+        root->right->parent = root;
+    }
+    else
+        return root;
+    return rebalance(root);
+}
 
-    insert->data = (PokemonData*)malloc(sizeof(PokemonData));
-    if (!insert->data) {
-        printf("Memory allocation failed.\n");
-        return;
+PokemonNode *insertPokemonNode(NodePool *pool, PokemonNode *root, PokemonNode *newNode) {
+    int inserted = 0;
+    uint64_t touched = opStats.tree[TREE_INSERT].nodesTouched;
+    root = insertAVL(root, newNode, &inserted);
+    root->parent = NULL;
+    recordTreeOp(TREE_INSERT, (int)(opStats.tree[TREE_INSERT].nodesTouched - touched));
+    if(!inserted) {
+        printf("Could not insert pokemon.\n");
+        freePokemonNode(pool, newNode);
     }
+    return root;
+}
 
-    *insert->data = pokedex[(choice-1)];
-    insert->left = NULL;
-    insert->right = NULL;
+PokemonNode *searchPokemonBFS(PokemonNode *root, int id) {
+    int depth = 0;
+    while(root != NULL) {
+        depth++;
+        if(root->data->id == id)
+            break;
+        root = root->data->id > id ? root->left : root->right;
+    }
+    opStats.tree[TREE_SEARCH].nodesTouched += (uint64_t)depth;
+    recordTreeOp(TREE_SEARCH, depth);
+    return root;
+}
 
-    if(owner->pokedexRoot == NULL) {
-        owner->pokedexRoot = insert;
-        printf("Pokemon %s (ID %d) added.\n", insert->data->name, insert->data->id);
-        return;
+PokemonNode *searchWithSuccessor(PokemonNode *root, int id, PokemonNode **successor) {
+    int depth = 0;
+    PokemonNode *after = NULL;
+    while(root != NULL) {
+        depth++;
+        if(root->data->id == id)
+            break;
+        //the last node we go left at is the closest larger ID above
+        if(root->data->id > id) {
+            after = root;
+            root = root->left;
+        }
+        else {
+            root = root->right;
+        }
+    }
+    if(root != NULL && root->right != NULL) {
+        after = root->right;
+        depth++;
+        while(after->left != NULL) {
+            after = after->left;
+            depth++;
+        }
     }
-    insertPokemonNode(owner->pokedexRoot, insert);
-    printf("Pokemon %s (ID %d) added.\n", insert->data->name, insert->data->id);
+    opStats.tree[TREE_SEARCH].nodesTouched += (uint64_t)depth;
+    recordTreeOp(TREE_SEARCH, depth);
+    *successor = root != NULL ? after : NULL;
+    return root;
 }
 
+void relabelPokemonNode(PokemonNode *node, const PokemonData *data) {
+    node->data = data;
+    //shape and sizes are unchanged; only the sums and maxima on the path up move
+    for(; node != NULL; node = node->parent)
+        updateNode(node);
+}
 
-/* ------------------------------------------------------------
-   2) Creating & Freeing Nodes
-   ------------------------------------------------------------ */
+static PokemonNode *removeAVL(NodePool *pool, PokemonNode *root, int id) {
+    if(!root)
+        return NULL;
+    opStats.tree[TREE_REMOVE].nodesTouched++;
+    if(root->data->id > id) {
+        root->left = removeAVL(pool, root->left, id);
+        if(root->left != NULL)
+            root->left->parent = root;
+    }
+    else if(root->data->id < id) {
+        root->right = removeAVL(pool, root->right, id);
+        if(root->right != NULL)
+            root->right->parent = root;
+    }
+    else {
+        //if the node has no children
+        if(root->left == NULL && root->right == NULL) {
+            freePokemonNode(pool, root);
+            return NULL;
+        }
+        //if the node has 1 child
+        if(!root->left) {
+            PokemonNode *temp = root->right;
+            temp->parent = root->parent;
+            freePokemonNode(pool, root);
+            return temp;
+        }
+        if(!root->right) {
+            PokemonNode *temp = root->left;
+            temp->parent = root->parent;
+            freePokemonNode(pool, root);
+            return temp;
+        }
+        //if the node has 2 children
+        PokemonNode *successor = findMinNode(root->right);
+        root->data = successor->data;
+        root->right = removeAVL(pool, root->right, successor->data->id);
+        if(root->right != NULL)
+            root->right->parent = root;
+    }
+    return rebalance(root);
+}
 
-void freePokemonNode(PokemonNode *node) {
-    if(!node)
-        return;
-    if(node->data)
-        free(node->data);
-    free(node);
+PokemonNode *removeNodeBST(NodePool *pool, PokemonNode *root, int id) {
+    uint64_t touched = opStats.tree[TREE_REMOVE].nodesTouched;
+    root = removeAVL(pool, root, id);
+    recordTreeOp(TREE_REMOVE, (int)(opStats.tree[TREE_REMOVE].nodesTouched - touched));
+    return root;
 }
-void freePokemonTree(PokemonNode *root) {
-    if (!root)
-        return;
-    freePokemonTree(root->left);
-    freePokemonTree(root->right);
-    freePokemonNode(root);
+
+PokemonNode *buildBalancedTree(PokemonNode **nodes, int n) {
+    if(n <= 0)
+        return NULL;
+    int mid = n / 2;
+    PokemonNode *root = nodes[mid];
+    root->parent = NULL;
+    root->left = buildBalancedTree(nodes, mid);
+    root->right = buildBalancedTree(nodes + mid + 1, n - mid - 1);
+    if(root->left != NULL)
+        root->left->parent = root;
+    if(root->right != NULL)
+        root->right->parent = root;
+    updateNode(root);
+    return root;
 }
-void freeOwnerNode(OwnerNode *owner) {
-    if(!owner)
-        return;
-    if(owner->pokedexRoot)
-        freePokemonTree(owner->pokedexRoot);
-    if(owner->ownerName)
-        free(owner->ownerName);
-    free(owner);
+
+PokemonNode *kthPokemonNode(PokemonNode *root, int k) {
+    while(root != NULL) {
+        int leftSize = nodeSize(root->left);
+        if(k <= leftSize) {
+            root = root->left;
+        }
+        else if(k == leftSize + 1) {
+            return root;
+        }
+        else {
+            k -= leftSize + 1;
+            root = root->right;
+        }
+    }
+    return NULL;
 }
 
-void freeAllOwners(int n) {
-    if (!ownerHead) return;
+int pokemonRank(PokemonNode *root, int id) {
+    int smaller = 0;
+    while(root != NULL) {
+        if(id <= root->data->id) {
+            root = root->left;
+        }
+        else {
+            smaller += nodeSize(root->left) + 1;
+            root = root->right;
+        }
+    }
+    return smaller;
+}
 
-    OwnerNode *current = ownerHead;
+PokemonNode *lowerBoundNode(PokemonNode *root, int id) {
+    PokemonNode *best = NULL;
+    while(root != NULL) {
+        if(root->data->id >= id) {
+            best = root;
+            root = root->left;
+        }
+        else {
+            root = root->right;
+        }
+    }
+    return best;
+}
 
-    while (n > 0) {
-        OwnerNode *next = current->next;
-        freeOwnerNode(current);
-        current = next;
+//totals over every ID below id (or up to it, if inclusive): whole left subtrees
+//are taken from their summaries
+static void addTotalsBelow(PokemonNode *root, int id, int inclusive, RangeTotals *t, int sign) {
+    while(root != NULL) {
+        if(id < root->data->id || (id == root->data->id && !inclusive)) {
+            root = root->left;
+            continue;
+        }
+        PokemonNode *l = root->left;
+        t->count += sign * (nodeSize(l) + 1);
+        t->hp += sign * ((l ? l->sumHp : 0) + root->data->hp);
+        t->attack += sign * ((l ? l->sumAttack : 0) + root->data->attack);
+        root = root->right;
+    }
+}
 
-        if (current == ownerHead) break;
+RangeTotals rangeTotals(PokemonNode *root, int lo, int hi) {
+    RangeTotals t = { 0, 0, 0 };
+    if(lo > hi)
+        return t;
+    addTotalsBelow(root, hi, 1, &t, 1);
+    addTotalsBelow(root, lo, 0, &t, -1);
+    return t;
+}
 
-        n--;
+int removePokemonByID(OwnerNode *owner, int id) {
+    if (!pokedexFind(owner, id)) {
+        printf("No Pokemon with ID %d found.\n", id);
+        return 0;
     }
+    printf("Removing Pokemon %s (ID %d).\n", pokedex[id - 1].name, pokedex[id - 1].id);
+    return pokedexRemove(owner, id);
+}
 
-    ownerHead = NULL;
+void freePokemon(OwnerNode *owner) {
+    int choice = readIntSafe("Enter Pokemon ID to release: ");
+    if (removePokemonByID(owner, choice))
+        journalRecord(JOURNAL_RELEASE, owner->ownerName, NULL, choice);
 }
-/* ------------------------------------------------------------
-   9) Circular List Linking & Searching
-   ------------------------------------------------------------ */
 
-void removeOwnerFromCircularList(OwnerNode *target) {
-    if(!target)
+void addPokemon(OwnerNode *owner) {
+    int choice = readIntSafe("Enter ID to add: ");
+    if(choice < 1 || choice > POKEDEX_SIZE) {
+        printf("Invalid ID.\n");
         return;
-
-    //if there is only 1 pokedex
-    if(target->next == target){
-        freeOwnerNode(target);
-        ownerHead = NULL;
+    }
+    if(pokedexFind(owner, choice) != NULL) {
+        printf("Pokemon with ID %d is already in the Pokedex. No changes made.\n", choice);
         return;
     }
 
-    target->prev->next = target->next;
-    target->next->prev = target->prev;
-
-    //if we are removing the head, move the head
-    if(ownerHead == target)
-        ownerHead = target->next;
-
-    freeOwnerNode(target);
+    if (!pokedexAdd(owner, choice))
+        return;
+    journalRecord(JOURNAL_ADD, owner->ownerName, NULL, choice);
+    printf("Pokemon %s (ID %d) added.\n", pokedex[choice-1].name, pokedex[choice-1].id);
 }
 
 /* ------------------------------------------------------------
-   10) Owner Menus
+   3b) Owner Pokedex Storage (AVL tree or species bitset)
    ------------------------------------------------------------ */
 
-void enterExistingPokedexMenu(int n)
-{
-    if(ownerHead == NULL) {
-        printf("No existing Pokedexes.\n");
-        return;
+static inline int bitCount(uint64_t word) {
+#if defined(__GNUC__)
+    return __builtin_popcountll(word);
+#else
+    int count = 0;
+    for(; word; word &= word - 1)
+        count++;
+    return count;
+#endif
+}
+
+static inline int lowestBit(uint64_t word) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(word);
+#else
+    int bit = 0;
+    while(!(word & 1)) {
+        word >>= 1;
+        bit++;
     }
-    // list owners
-    printf("\nExisting Pokedexes:\n");
-    // you need to implement a few things here :)
-    OwnerNode *temp = ownerHead;
-    for (int i = 0; i < n; i++) {
-        printf("%d. %s\n", i + 1, temp->ownerName);
-        temp = temp->next;
+    return bit;
+#endif
+}
+
+//fill ids[] with the owned species in ascending order, return how many
+static int bitsetToIds(const uint64_t *bits, int *ids) {
+    int n = 0;
+    for(int w = 0; w < POKEDEX_WORDS; w++) {
+        for(uint64_t word = bits[w]; word; word &= word - 1)
+            ids[n++] = w * 64 + lowestBit(word) + 1;
     }
-    int choice = readIntSafe("Choose a Pokedex by number: ");
-    //navigate the list to the current choice and save it so we can work on it
-    for(int i = 0; i < choice-1; i++)
-        temp = temp->next;
-    OwnerNode *cur = temp;
-    printf("\nEntering %s's Pokedex...\n", cur->ownerName);
+    return n;
+}
 
-    int subChoice;
-    do
-    {
-        printf("\n-- %s's Pokedex Menu --\n", cur->ownerName);
-        printf("1. Add Pokemon\n");
-        printf("2. Display Pokedex\n");
-        printf("3. Release Pokemon (by ID)\n");
-        printf("4. Pokemon Fight!\n");
-        printf("5. Evolve Pokemon\n");
-        printf("6. Back to Main\n");
+static void setBitVisit(PokemonNode *node, void *ctx) {
+    uint64_t *bits = (uint64_t *)ctx;
+    int bit = node->data->id - 1;
+    bits[bit >> 6] |= (uint64_t)1 << (bit & 63);
+}
 
-        subChoice = readIntSafe("Your choice: ");
+static void treeToBitset(PokemonNode *root, uint64_t *bits) {
+    walkTreeMorris(root, ORDER_IN, setBitVisit, bits);
+}
 
-        switch (subChoice)
-        {
-        case 1:
-            addPokemon(cur);
-            break;
-        case 2:
-            displayMenu(cur);
-            break;
-        case 3:
-            if(cur->pokedexRoot == NULL) {
-                printf("No Pokemon to release.\n");
-                break;
-            }
-            freePokemon(cur);
-            break;
-        case 4:
-            pokemonFight(cur);
-            break;
-        case 5:
-            evolvePokemon(cur);
-            break;
-        case 6:
-            printf("Back to Main Menu.\n");
-            break;
-        default:
-            printf("Invalid choice.\n");
+const PokemonData *pokedexFind(OwnerNode *owner, int id) {
+    if(id < 1 || id > POKEDEX_SIZE)
+        return NULL;
+    if(owner->storage == STORAGE_BITSET) {
+        int bit = id - 1;
+        return ((owner->bits[bit >> 6] >> (bit & 63)) & 1) ? &pokedex[bit] : NULL;
+    }
+    PokemonNode *node = searchPokemonBFS(owner->pokedexRoot, id);
+    return node ? node->data : NULL;
+}
+
+int pokedexAdd(OwnerNode *owner, int id) {
+    if(id < 1 || id > POKEDEX_SIZE || pokedexFind(owner, id))
+        return 0;
+    //index first, so a failed allocation on either side leaves both unchanged
+    if(!speciesIndexAdd(owner, id))
+        return 0;
+    if(owner->storage == STORAGE_BITSET) {
+        int bit = id - 1;
+        owner->bits[bit >> 6] |= (uint64_t)1 << (bit & 63);
+    }
+    else {
+        PokemonNode *insert = createPokemonNode(&owner->pool, &pokedex[id - 1]);
+        if (!insert) {
+            speciesIndexRemove(owner, id);
+            return 0;
         }
-    } while (subChoice != 6);
+        owner->pokedexRoot = insertPokemonNode(&owner->pool, owner->pokedexRoot, insert);
+    }
+    owner->pokemonCount++;
+    applyStoragePolicy(owner);
+    return 1;
 }
 
-void deletePokedex(int n) {
-    printf("\n=== Delete a Pokedex ===\n");
-    OwnerNode *temp = ownerHead;
-    for (int i = 0; i < n; i++) {
-        printf("%d. %s\n", i + 1, temp->ownerName);
-        temp = temp->next;
+int pokedexRemove(OwnerNode *owner, int id) {
+    if(!pokedexFind(owner, id))
+        return 0;
+    if(owner->storage == STORAGE_BITSET) {
+        int bit = id - 1;
+        owner->bits[bit >> 6] &= ~((uint64_t)1 << (bit & 63));
     }
-    int choice = readIntSafe("Choose a Pokedex to delete by number: ");
+    else {
+        owner->pokedexRoot = removeNodeBST(&owner->pool, owner->pokedexRoot, id);
+    }
+    owner->pokemonCount--;
+    speciesIndexRemove(owner, id);
+    applyStoragePolicy(owner);
+    return 1;
+}
 
-    //navigate to the node to delete
-    for(int i = 0; i < choice-1; i++)
-        temp = temp->next;
+PokemonNode *pokedexView(OwnerNode *owner, PokemonNode *scratch) {
+    if(owner->storage != STORAGE_BITSET)
+        return owner->pokedexRoot;
+    int ids[POKEDEX_SIZE];
+    PokemonNode *nodes[POKEDEX_SIZE];
+    int n = bitsetToIds(owner->bits, ids);
+    for(int i = 0; i < n; i++) {
+        scratch[i].data = &pokedex[ids[i] - 1];
+        nodes[i] = &scratch[i];
+    }
+    return buildBalancedTree(nodes, n);
+}
 
-    printf("Deleting %s's entire Pokedex...\nPokedex deleted.", temp->ownerName);
+const PokemonData *pokedexKth(OwnerNode *owner, int k) {
+    if(k < 1 || k > owner->pokemonCount)
+        return NULL;
+    if(owner->storage != STORAGE_BITSET)
+        return kthPokemonNode(owner->pokedexRoot, k)->data;
+    //skip whole words by popcount, then walk the bits of the right one
+    for(int w = 0; w < POKEDEX_WORDS; w++) {
+        int inWord = bitCount(owner->bits[w]);
+        if(k > inWord) {
+            k -= inWord;
+            continue;
+        }
+        uint64_t word = owner->bits[w];
+        while(--k > 0)
+            word &= word - 1;
+        return &pokedex[w * 64 + lowestBit(word)];
+    }
+    return NULL;
+}
 
-    removeOwnerFromCircularList(temp);
+int pokedexRank(OwnerNode *owner, int id) {
+    if(!pokedexFind(owner, id))
+        return 0;
+    if(owner->storage != STORAGE_BITSET)
+        return pokemonRank(owner->pokedexRoot, id) + 1;
+    int bit = id - 1, rank = 1;
+    for(int w = 0; w < bit >> 6; w++)
+        rank += bitCount(owner->bits[w]);
+    return rank + bitCount(owner->bits[bit >> 6] & (((uint64_t)1 << (bit & 63)) - 1));
 }
 
-void mergePokedexMenu(int n) {
-    printf("\n=== Merge Pokedexes ===\n");
-    printf("Enter name of first owner: ");
-    char* firstName = getDynamicInput();
-    printf("Enter name of second owner: ");
-    char* secondName = getDynamicInput();
+static PokemonNode *nextInOrder(PokemonNode *node);
 
-    OwnerNode *first = NULL, *second = NULL;
-    OwnerNode *temp = ownerHead;
+//the set bits of a bitset inside [lo, hi], one word at a time
+static uint64_t rangeMask(int w, int lo, int hi) {
+    int first = lo - 1 - w * 64, last = hi - 1 - w * 64;
+    if(last < 0 || first > 63)
+        return 0;
+    uint64_t mask = ~(uint64_t)0;
+    if(first > 0)
+        mask &= ~(uint64_t)0 << first;
+    if(last < 63)
+        mask &= ~(uint64_t)0 >> (63 - last);
+    return mask;
+}
 
-    //save the wanted owners
-    for(int i = 0; i < n; i++) {
-        if(strcmp(firstName, temp->ownerName) == 0) {
-            first = temp;
-        }
-        if(strcmp(secondName, temp->ownerName) == 0) {
-            second = temp;
+//clip [lo, hi] to the catalog's IDs; 0 if nothing is left
+static int clampRange(int *lo, int *hi) {
+    if(*lo > POKEDEX_SIZE || *hi < 1 || *lo > *hi)
+        return 0;
+    if(*lo < 1)
+        *lo = 1;
+    if(*hi > POKEDEX_SIZE)
+        *hi = POKEDEX_SIZE;
+    return 1;
+}
+
+int pokedexRange(OwnerNode *owner, int lo, int hi, const PokemonData **out) {
+    int n = 0;
+    if(!clampRange(&lo, &hi))
+        return 0;
+    if(owner->storage == STORAGE_BITSET) {
+        for(int w = 0; w < POKEDEX_WORDS; w++) {
+            for(uint64_t word = owner->bits[w] & rangeMask(w, lo, hi); word; word &= word - 1)
+                out[n++] = &pokedex[w * 64 + lowestBit(word)];
         }
-        temp = temp->next;
+        return n;
     }
+    //descend once to the first ID >= lo, then step through successors up to hi
+    for(PokemonNode *node = lowerBoundNode(owner->pokedexRoot, lo);
+        node != NULL && node->data->id <= hi; node = nextInOrder(node))
+        out[n++] = node->data;
+    return n;
+}
 
-    printf("Merging %s and %s...\n", firstName, secondName);
-    Queue *q = createQueue();
-    enqueue(q, second->pokedexRoot);
-    //transfer pokemons from 1 owner to another
-    while(!isEmpty(q)) {
-        PokemonNode *cur = dequeue(q);
-        PokemonNode *newNode = (PokemonNode *)malloc(sizeof(PokemonNode));
-        newNode->data = (PokemonData *)malloc(sizeof(PokemonData));
-        *newNode->data = *cur->data;
-        newNode->left = NULL;
-        newNode->right = NULL;
-        newNode->parent = NULL;
-        insertPokemonNode(first->pokedexRoot, newNode);
-        if(cur->left != NULL) {
-            enqueue(q, cur->left);
-        }
-        if(cur->right != NULL) {
-            enqueue(q, cur->right);
+RangeTotals pokedexRangeTotals(OwnerNode *owner, int lo, int hi) {
+    RangeTotals t = { 0, 0, 0 };
+    if(!clampRange(&lo, &hi))
+        return t;
+    if(owner->storage != STORAGE_BITSET)
+        return rangeTotals(owner->pokedexRoot, lo, hi);
+    for(int w = 0; w < POKEDEX_WORDS; w++) {
+        uint64_t word = owner->bits[w] & rangeMask(w, lo, hi);
+        t.count += bitCount(word);
+        for(; word; word &= word - 1) {
+            const PokemonData *p = &pokedex[w * 64 + lowestBit(word)];
+            t.hp += p->hp;
+            t.attack += p->attack;
         }
     }
-    freeQueue(q);
+    return t;
+}
 
-    removeOwnerFromCircularList(second);
+int pokedexOfType(OwnerNode *owner, PokemonType type, const PokemonData **out) {
+    int count, n = 0;
+    const int *ids = typeSpecies(type, &count);
+    //only this type's species are probed, each in O(1) through its index slot
+    for(int i = 0; i < count && n < owner->typeCounts[type]; i++) {
+        if(owner->speciesSlot[ids[i] - 1] >= 0)
+            out[n++] = &pokedex[ids[i] - 1];
+    }
+    return n;
+}
 
-    printf("Merge completed.\n");
-    printf("Owner '%s' has been removed after merging.\n", secondName);
-    free(firstName);
-    free(secondName);
+//scoreOrder[r] = index of the r-th strongest species
+static int scoreOrder[POKEDEX_SIZE];
+static int scoreOrderReady = 0;
+
+static int compareSpeciesByScore(const void *a, const void *b) {
+    const PokemonData *pa = &pokedex[*(const int *)a], *pb = &pokedex[*(const int *)b];
+    return pokemonStronger(pa, pb) ? -1 : pokemonStronger(pb, pa);
 }
 
-void sortOwners(int n) {
-    OwnerNode *temp = ownerHead;
-    for(int i =0; i < n; i++) {
-        for(int j = i; j < n-1; j++) {
-            if(strcmp(temp->ownerName, temp->next->ownerName) > 0)
-                swapOwnerData(temp, temp->next);
-        }
-        temp = ownerHead;
+const int *speciesByScore(void) {
+    if(!scoreOrderReady) {
+        for(int i = 0; i < POKEDEX_SIZE; i++)
+            scoreOrder[i] = i;
+        qsort(scoreOrder, POKEDEX_SIZE, sizeof(int), compareSpeciesByScore);
+        scoreOrderReady = 1;
     }
-    printf("Owners sorted by name.\n");
+    return scoreOrder;
 }
 
-void swapOwnerData(OwnerNode *a, OwnerNode *b) {
-    //swap names
-    char* tempName = a->ownerName;
-    a->ownerName = b->ownerName;
-    b->ownerName = tempName;
+const PokemonData *pokedexStrongest(OwnerNode *owner) {
+    if(owner->pokemonCount == 0)
+        return NULL;
+    if(owner->storage != STORAGE_BITSET)
+        return owner->pokedexRoot->best;
+    //strongest species first; the first one that is set wins
+    const int *order = speciesByScore();
+    for(int r = 0; ; r++) {
+        int bit = order[r];
+        if((owner->bits[bit >> 6] >> (bit & 63)) & 1)
+            return &pokedex[bit];
+    }
+}
 
-    //swap data
-    PokemonNode *tempPokedexRoot = a->pokedexRoot;
-    a->pokedexRoot = b->pokedexRoot;
-    b->pokedexRoot = tempPokedexRoot;
+double pokedexTeamScore(OwnerNode *owner) {
+    return owner->totalAttack * 1.5 + owner->totalHp * 1.2;
 }
 
-void printOwnersCircular() {
-    printf("Enter direction (F or B): ");
-    char *direction = getDynamicInput();
-    int amount = readIntSafe("How many prints? ");
-    OwnerNode *temp = ownerHead;
-    switch(*direction) {
-        case 'f': {
-            for(int i = 0; i < amount; i++) {
-                printf("[%d] %s\n", i+1,temp->ownerName);
-                temp = temp->next;
-            }
-            break;
+int pokedexPage(OwnerNode *owner, int page, int pageSize, const PokemonData **out) {
+    //compare page numbers, not (page - 1) * pageSize, which can overflow
+    if(page < 1 || pageSize < 1 || owner->pokemonCount == 0 ||
+       page - 1 >= (owner->pokemonCount - 1) / pageSize + 1)
+        return 0;
+    int first = (page - 1) * pageSize + 1;
+    int n = owner->pokemonCount - first + 1;
+    if(n > pageSize)
+        n = pageSize;
+    if(owner->storage == STORAGE_BITSET) {
+        int ids[POKEDEX_SIZE];
+        bitsetToIds(owner->bits, ids);
+        for(int i = 0; i < n; i++)
+            out[i] = &pokedex[ids[first - 1 + i] - 1];
+        return n;
+    }
+    //O(log n) to the first entry, then successor steps
+    PokemonNode *node = kthPokemonNode(owner->pokedexRoot, first);
+    for(int i = 0; i < n; i++, node = nextInOrder(node))
+        out[i] = node->data;
+    return n;
+}
+
+void setPokedexStorage(OwnerNode *owner, StorageMode mode) {
+    if(owner->storage == mode)
+        return;
+    if(mode == STORAGE_BITSET) {
+        memset(owner->bits, 0, sizeof(owner->bits));
+        treeToBitset(owner->pokedexRoot, owner->bits);
+        poolRelease(&owner->pool);
+        owner->pokedexRoot = NULL;
+        owner->storage = STORAGE_BITSET;
+        return;
+    }
+    //sorted IDs straight into a balanced tree, no per-node descents
+    int ids[POKEDEX_SIZE];
+    PokemonNode *nodes[POKEDEX_SIZE];
+    int n = bitsetToIds(owner->bits, ids);
+    for(int i = 0; i < n; i++) {
+        nodes[i] = createPokemonNode(&owner->pool, &pokedex[ids[i] - 1]);
+        if(nodes[i] == NULL)
+            return;
+    }
+    owner->pokedexRoot = buildBalancedTree(nodes, n);
+    memset(owner->bits, 0, sizeof(owner->bits));
+    owner->storage = STORAGE_TREE;
+}
+
+//in-order successor using parent links (no stack, no recursion)
+static PokemonNode *nextInOrder(PokemonNode *node) {
+    if(node->right != NULL)
+        return findMinNode(node->right);
+    while(node->parent != NULL && node == node->parent->right)
+        node = node->parent;
+    return node->parent;
+}
+
+static int collectInOrder(PokemonNode *root, PokemonNode **out) {
+    int n = 0;
+    for(PokemonNode *cur = findMinNode(root); cur != NULL; cur = nextInOrder(cur))
+        out[n++] = cur;
+    return n;
+}
+
+int mergePokedexes(OwnerNode *first, OwnerNode *second, int *droppedIds) {
+    int dropped = 0;
+    //settle storage before the index moves: if second can't become a tree, first becomes a bitset
+    if(first->storage != STORAGE_BITSET && second->storage == STORAGE_BITSET) {
+        setPokedexStorage(second, STORAGE_TREE);
+        if(second->storage == STORAGE_BITSET)
+            setPokedexStorage(first, STORAGE_BITSET);
+    }
+    //every species second held now belongs to first; second's slot is freed first, so no add can fail
+    for(int id = 1; id <= POKEDEX_SIZE; id++) {
+        if(second->speciesSlot[id - 1] >= 0) {
+            speciesIndexRemove(second, id);
+            speciesIndexAdd(first, id);
         }
-        case 'F': {
-            for(int i = 0; i < amount; i++) {
-                printf("[%d] %s\n", i+1,temp->ownerName);
-                temp = temp->next;
-            }
-            break;
+    }
+    if(first->storage == STORAGE_BITSET) {
+        //fold second's species into first's words
+        uint64_t other[POKEDEX_WORDS];
+        memcpy(other, second->bits, sizeof(other));
+        if(second->storage != STORAGE_BITSET) {
+            memset(other, 0, sizeof(other));
+            treeToBitset(second->pokedexRoot, other);
         }
-        case 'b': {
-            for(int i = 0; i < amount; i++) {
-                printf("[%d] %s\n", i+1,temp->ownerName);
-                temp = temp->prev;
+        int count = 0;
+        for(int w = 0; w < POKEDEX_WORDS; w++) {
+            for(uint64_t dup = first->bits[w] & other[w]; dup; dup &= dup - 1) {
+                if(droppedIds != NULL)
+                    droppedIds[dropped] = w * 64 + lowestBit(dup) + 1;
+                dropped++;
             }
-            break;
+            first->bits[w] |= other[w];
+            count += bitCount(first->bits[w]);
         }
-        case 'B': {
-            for(int i = 0; i < amount; i++) {
-                printf("[%d] %s\n", i+1,temp->ownerName);
-                temp = temp->prev;
+        first->pokemonCount = count;
+    }
+    else {
+        //both trees flattened in order; IDs are bounded so the arrays live on the stack
+        PokemonNode *a[POKEDEX_SIZE], *b[POKEDEX_SIZE], *merged[POKEDEX_SIZE];
+        int na = collectInOrder(first->pokedexRoot, a);
+        int nb = collectInOrder(second->pokedexRoot, b);
+        //second's nodes are relinked, so first takes over the slabs they live in
+        poolAdopt(&first->pool, &second->pool);
+        int i = 0, j = 0, n = 0;
+        while(i < na && j < nb) {
+            if(a[i]->data->id < b[j]->data->id)
+                merged[n++] = a[i++];
+            else if(a[i]->data->id > b[j]->data->id)
+                merged[n++] = b[j++];
+            else {
+                if(droppedIds != NULL)
+                    droppedIds[dropped] = b[j]->data->id;
+                freePokemonNode(&first->pool, b[j++]);
+                dropped++;
             }
-            break;
         }
+        while(i < na)
+            merged[n++] = a[i++];
+        while(j < nb)
+            merged[n++] = b[j++];
+        first->pokedexRoot = buildBalancedTree(merged, n);
+        first->pokemonCount = n;
     }
-    free(direction);
+    second->pokedexRoot = NULL;
+    second->pokemonCount = 0;
+    memset(second->bits, 0, sizeof(second->bits));
+    applyStoragePolicy(first);
+    return dropped;
 }
 
-void openPokedexMenu( char *name) {
-    if(ownerHead == NULL) {
-        ownerHead = (OwnerNode*)malloc(sizeof(OwnerNode));
-        if (!ownerHead) {
-            printf("Memory allocation failed.\n");
-            return;
-        }
-        ownerHead->ownerName = name;
-        ownerHead->pokedexRoot = NULL;
+void applyStoragePolicy(OwnerNode *owner) {
+    if(storagePolicy != STORAGE_AUTO || owner->storageLocked)
+        return;
+    //hysteresis so an owner hovering at the threshold doesn't flip on every add/release
+    if(owner->storage == STORAGE_TREE && owner->pokemonCount >= BITSET_DENSE_COUNT)
+        setPokedexStorage(owner, STORAGE_BITSET);
+    else if(owner->storage == STORAGE_BITSET && owner->pokemonCount < BITSET_SPARSE_COUNT)
+        setPokedexStorage(owner, STORAGE_TREE);
+}
 
-        printf("Choose Starter:\n1. Bulbasaur\n2. Charmander\n3. Squirtle\n");
-        int choice = readIntSafe("Your choice: ");
 
-        ownerHead->pokedexRoot = (PokemonNode*)malloc(sizeof(PokemonNode));
-        if (!ownerHead->pokedexRoot) {
-            printf("Memory allocation failed.\n");
-            return;
-        }
+/* ------------------------------------------------------------
+   2) Creating & Freeing Nodes
+   ------------------------------------------------------------ */
 
-        ownerHead->pokedexRoot->data = (PokemonData*)malloc(sizeof(PokemonData));
-        if (!ownerHead->pokedexRoot->data) {
+PokemonNode *poolAllocNode(NodePool *pool) {
+    PokemonNode *node = pool->freeList;
+    opStats.nodeAllocs++;
+    if(node != NULL) {
+        pool->freeList = node->left;
+        return node;
+    }
+    PoolSlab *slab = pool->slabs;
+    if(slab == NULL || slab->used == slab->capacity) {
+        //each new slab doubles the previous one, so tiny owners stay tiny
+        int capacity = POOL_FIRST_SLAB;
+        if(slab != NULL && slab->capacity < POOL_MAX_SLAB)
+            capacity = slab->capacity * 2;
+        else if(slab != NULL)
+            capacity = POOL_MAX_SLAB;
+        slab = (PoolSlab *)exMalloc(sizeof(PoolSlab) + capacity * sizeof(PokemonNode), MEM_NODES);
+        if (!slab) {
             printf("Memory allocation failed.\n");
-            return;
+            return NULL;
         }
-        *ownerHead->pokedexRoot->data = pokedex[(choice-1)*3];
-        ownerHead->pokedexRoot->left = NULL;
-        ownerHead->pokedexRoot->right = NULL;
-        ownerHead->pokedexRoot->parent = NULL;
+        slab->capacity = capacity;
+        slab->used = 0;
+        slab->next = pool->slabs;
+        pool->slabs = slab;
+    }
+    return &slab->slots[slab->used++];
+}
+
+void poolFreeNode(NodePool *pool, PokemonNode *node) {
+    node->left = pool->freeList;
+    pool->freeList = node;
+}
 
-        ownerHead->next = ownerHead;
-        ownerHead->prev = ownerHead;
+void poolRelease(NodePool *pool) {
+    PoolSlab *slab = pool->slabs;
+    while(slab != NULL) {
+        PoolSlab *next = slab->next;
+        exFree(slab);
+        slab = next;
     }
-    else {
-        OwnerNode *newPokedex = malloc(sizeof(OwnerNode));
-        if (!newPokedex) {
-            printf("Memory allocation failed.\n");
-            return;
+    pool->slabs = NULL;
+    pool->freeList = NULL;
+}
+
+void poolAdopt(NodePool *dst, NodePool *src) {
+    if(src->slabs != NULL) {
+        //keep dst's newest slab at the head so bump allocation continues there
+        PoolSlab *tail = src->slabs;
+        while(tail->next != NULL)
+            tail = tail->next;
+        if(dst->slabs == NULL) {
+            dst->slabs = src->slabs;
         }
-        newPokedex->ownerName = name;
-        newPokedex->pokedexRoot = NULL;
+        else {
+            tail->next = dst->slabs->next;
+            dst->slabs->next = src->slabs;
+        }
+    }
+    if(src->freeList != NULL) {
+        PokemonNode *last = src->freeList;
+        while(last->left != NULL)
+            last = last->left;
+        last->left = dst->freeList;
+        dst->freeList = src->freeList;
+    }
+    src->slabs = NULL;
+    src->freeList = NULL;
+}
 
-        printf("Choose Starter:\n1. Bulbasaur\n2. Charmander\n3. Squirtle\n");
-        int choice = readIntSafe("Your choice: ");
+PokemonNode *createPokemonNode(NodePool *pool, const PokemonData *data) {
+    PokemonNode *node = poolAllocNode(pool);
+    if(!node)
+        return NULL;
+    node->data = data;
+    node->left = NULL;
+    node->right = NULL;
+    node->parent = NULL;
+    updateNode(node);
+    return node;
+}
 
-        newPokedex->pokedexRoot = (PokemonNode*)malloc(sizeof(PokemonNode));
-        if (!newPokedex->pokedexRoot) {
-            printf("Memory allocation failed.\n");
+void freePokemonNode(NodePool *pool, PokemonNode *node) {
+    if(!node)
+        return;
+    poolFreeNode(pool, node);
+}
+void freeOwnerNode(OwnerNode *owner) {
+    if(!owner)
+        return;
+    speciesIndexDropOwner(owner);
+    //every node of the Pokedex lives in the owner's slabs, so no tree walk is needed
+    poolRelease(&owner->pool);
+    if(owner->ownerName)
+        exFree(owner->ownerName);
+    exFree(owner);
+}
+
+void freeAllOwners(int n) {
+    if (fastShutdown) {
+        ownerHead = NULL;
+        return;
+    }
+    //the index table outlives its last owner, so it is freed even with no owners left
+    ownerIndexClear();
+
+    OwnerNode *current = ownerHead;
+
+    while (current != NULL && n > 0) {
+        OwnerNode *next = current->next;
+        freeOwnerNode(current);
+        current = next;
+
+        if (current == ownerHead) break;
+
+        n--;
+    }
+    //after the owners, which drop themselves from it; its lists outlive the last owner too
+    speciesIndexClear();
+
+    ownerHead = NULL;
+}
+/* ------------------------------------------------------------
+   9) Circular List Linking & Searching
+   ------------------------------------------------------------ */
+
+//marks a deleted slot so probe chains stay intact
+static OwnerNode ownerTombstone;
+
+static uint64_t hashName(const char *name) {
+    //FNV-1a
+    uint64_t h = 14695981039346656037ULL;
+    for (; *name; name++) {
+        h ^= (unsigned char)*name;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static int ownerIndexGrow(void) {
+    int capacity = ownerIndex.capacity ? ownerIndex.capacity * 2 : OWNER_INDEX_MIN;
+    //plenty of tombstones alone: rehash in place at the same size
+    if (ownerIndex.count * 4 < ownerIndex.capacity)
+        capacity = ownerIndex.capacity;
+    OwnerNode **slots = (OwnerNode **)exCalloc(capacity, sizeof(OwnerNode *), MEM_OWNERS);
+    if (!slots) {
+        printf("Memory allocation failed.\n");
+        return 0;
+    }
+    for (int i = 0; i < ownerIndex.capacity; i++) {
+        OwnerNode *owner = ownerIndex.slots[i];
+        if (owner == NULL || owner == &ownerTombstone)
+            continue;
+        int j = (int)(hashName(owner->ownerName) & (uint64_t)(capacity - 1));
+        while (slots[j] != NULL)
+            j = (j + 1) & (capacity - 1);
+        slots[j] = owner;
+    }
+    exFree(ownerIndex.slots);
+    ownerIndex.slots = slots;
+    ownerIndex.capacity = capacity;
+    ownerIndex.tombstones = 0;
+    return 1;
+}
+
+int ownerIndexInsert(OwnerNode *owner) {
+    //keep live + deleted slots at most half full so probes stay short
+    if ((ownerIndex.count + ownerIndex.tombstones + 1) * 2 > ownerIndex.capacity && !ownerIndexGrow())
+        return 0;
+    int mask = ownerIndex.capacity - 1;
+    int i = (int)(hashName(owner->ownerName) & (uint64_t)mask);
+    while (ownerIndex.slots[i] != NULL && ownerIndex.slots[i] != &ownerTombstone)
+        i = (i + 1) & mask;
+    if (ownerIndex.slots[i] == &ownerTombstone)
+        ownerIndex.tombstones--;
+    ownerIndex.slots[i] = owner;
+    ownerIndex.count++;
+    return 1;
+}
+
+void ownerIndexRemove(OwnerNode *owner) {
+    if (ownerIndex.capacity == 0)
+        return;
+    int mask = ownerIndex.capacity - 1;
+    int i = (int)(hashName(owner->ownerName) & (uint64_t)mask);
+    while (ownerIndex.slots[i] != NULL) {
+        if (ownerIndex.slots[i] == owner) {
+            ownerIndex.slots[i] = &ownerTombstone;
+            ownerIndex.count--;
+            ownerIndex.tombstones++;
             return;
         }
+        i = (i + 1) & mask;
+    }
+}
+
+void ownerIndexClear(void) {
+    exFree(ownerIndex.slots);
+    ownerIndex.slots = NULL;
+    ownerIndex.capacity = 0;
+    ownerIndex.count = 0;
+    ownerIndex.tombstones = 0;
+}
+
+OwnerNode *findOwnerByName(const char *name) {
+    if (ownerIndex.capacity == 0)
+        return NULL;
+    int mask = ownerIndex.capacity - 1;
+    int i = (int)(hashName(name) & (uint64_t)mask);
+    while (ownerIndex.slots[i] != NULL) {
+        OwnerNode *owner = ownerIndex.slots[i];
+        if (owner != &ownerTombstone && strcmp(owner->ownerName, name) == 0)
+            return owner;
+        i = (i + 1) & mask;
+    }
+    return NULL;
+}
 
-        newPokedex->pokedexRoot->data = (PokemonData*)malloc(sizeof(PokemonData));
-        if (!newPokedex->pokedexRoot->data) {
+int speciesIndexAdd(OwnerNode *owner, int id) {
+    if (id < 1 || id > POKEDEX_SIZE || owner->speciesSlot[id - 1] >= 0)
+        return 1;
+    SpeciesHolders *holders = &speciesIndex[id - 1];
+    if (holders->count == holders->capacity) {
+        int capacity = holders->capacity ? holders->capacity * 2 : 4;
+        OwnerNode **grown = (OwnerNode **)exRealloc(holders->owners, capacity * sizeof(OwnerNode *), MEM_OWNERS);
+        if (!grown) {
             printf("Memory allocation failed.\n");
-            return;
+            return 0;
         }
-        *newPokedex->pokedexRoot->data = pokedex[(choice-1)*3];
-        newPokedex->pokedexRoot->left = NULL;
-        newPokedex->pokedexRoot->right = NULL;
-        newPokedex->pokedexRoot->parent = NULL;
+        holders->owners = grown;
+        holders->capacity = capacity;
+    }
+    owner->speciesSlot[id - 1] = holders->count;
+    holders->owners[holders->count++] = owner;
+    owner->typeCounts[pokedex[id - 1].TYPE]++;
+    owner->totalHp += pokedex[id - 1].hp;
+    owner->totalAttack += pokedex[id - 1].attack;
+    return 1;
+}
+
+void speciesIndexRemove(OwnerNode *owner, int id) {
+    if (id < 1 || id > POKEDEX_SIZE || owner->speciesSlot[id - 1] < 0)
+        return;
+    SpeciesHolders *holders = &speciesIndex[id - 1];
+    int slot = owner->speciesSlot[id - 1];
+    //the last holder moves into the hole, so removal is O(1)
+    OwnerNode *last = holders->owners[--holders->count];
+    holders->owners[slot] = last;
+    last->speciesSlot[id - 1] = slot;
+    owner->speciesSlot[id - 1] = -1;
+    owner->typeCounts[pokedex[id - 1].TYPE]--;
+    owner->totalHp -= pokedex[id - 1].hp;
+    owner->totalAttack -= pokedex[id - 1].attack;
+}
+
+void speciesIndexDropOwner(OwnerNode *owner) {
+    for (int id = 1; id <= POKEDEX_SIZE; id++)
+        speciesIndexRemove(owner, id);
+}
+
+void speciesIndexClear(void) {
+    for (int i = 0; i < POKEDEX_SIZE; i++) {
+        exFree(speciesIndex[i].owners);
+        speciesIndex[i].owners = NULL;
+        speciesIndex[i].count = 0;
+        speciesIndex[i].capacity = 0;
+    }
+}
+
+int speciesHolderCount(int id) {
+    return (id < 1 || id > POKEDEX_SIZE) ? 0 : speciesIndex[id - 1].count;
+}
 
+OwnerNode *const *speciesHolders(int id, int *count) {
+    *count = speciesHolderCount(id);
+    return *count > 0 ? speciesIndex[id - 1].owners : NULL;
+}
+
+int typeHolderCount(PokemonType type) {
+    int count, total = 0;
+    const int *ids = typeSpecies(type, &count);
+    for (int i = 0; i < count; i++)
+        total += speciesIndex[ids[i] - 1].count;
+    return total;
+}
+
+int forEachOfType(PokemonType type, HolderVisit visit, void *ctx) {
+    int count, visited = 0;
+    const int *ids = typeSpecies(type, &count);
+    //species of other types are never looked at, and neither is any tree
+    for (int i = 0; i < count; i++) {
+        const SpeciesHolders *holders = &speciesIndex[ids[i] - 1];
+        for (int k = 0; k < holders->count; k++)
+            visit(holders->owners[k], &pokedex[ids[i] - 1], ctx);
+        visited += holders->count;
+    }
+    return visited;
+}
+
+int forEachTopPokemon(int k, HolderVisit visit, void *ctx) {
+    const int *order = speciesByScore();
+    int visited = 0;
+    //species strongest-first; each one's holders share its score, so the
+    //first k pairs met are the top k and no per-owner data is read
+    for (int r = 0; r < POKEDEX_SIZE && visited < k; r++) {
+        const SpeciesHolders *holders = &speciesIndex[order[r]];
+        for (int i = 0; i < holders->count && visited < k; i++, visited++)
+            visit(holders->owners[i], &pokedex[order[r]], ctx);
+    }
+    return visited;
+}
+
+int linkOwnerInCircularList(OwnerNode *newOwner) {
+    //index first: an owner in the ring but not the index would drop out of every count
+    if (!ownerIndexInsert(newOwner))
+        return 0;
+    if (ownerHead == NULL) {
+        ownerHead = newOwner;
+        newOwner->next = newOwner;
+        newOwner->prev = newOwner;
+    }
+    else {
         OwnerNode *last = ownerHead->prev;
-        newPokedex->next = ownerHead;
-        newPokedex->prev = last;
-        last->next = newPokedex;
-        ownerHead->prev = newPokedex;
+        newOwner->next = ownerHead;
+        newOwner->prev = last;
+        last->next = newOwner;
+        ownerHead->prev = newOwner;
     }
-    printf("New Pokedex created for %s with starter %s.\n", ownerHead->prev->ownerName,
-                                                        ownerHead->prev->pokedexRoot->data->name);
+    return 1;
 }
 
+void removeOwnerFromCircularList(OwnerNode *target) {
+    if(!target)
+        return;
+    ownerIndexRemove(target);
 
-// --------------------------------------------------------------
-// Main Menu
-// --------------------------------------------------------------
-void mainMenu()
+    //if there is only 1 pokedex
+    if(target->next == target){
+        freeOwnerNode(target);
+        ownerHead = NULL;
+        return;
+    }
+
+    target->prev->next = target->next;
+    target->next->prev = target->prev;
+
+    //if we are removing the head, move the head
+    if(ownerHead == target)
+        ownerHead = target->next;
+
+    freeOwnerNode(target);
+}
+
+/* ------------------------------------------------------------
+   10) Owner Menus
+   ------------------------------------------------------------ */
+
+void enterExistingPokedexMenu(int n)
 {
-    int choice, numOfPokedexes = 0;
+    if(ownerHead == NULL) {
+        printf("No existing Pokedexes.\n");
+        return;
+    }
+    // list owners
+    printf("\nExisting Pokedexes:\n");
+    // you need to implement a few things here :)
+    OwnerNode *temp = ownerHead;
+    for (int i = 0; i < n; i++) {
+        printf("%d. %s\n", i + 1, temp->ownerName);
+        temp = temp->next;
+    }
+    int choice = readIntSafe("Choose a Pokedex by number: ");
+    //navigate the list to the current choice and save it so we can work on it
+    for(int i = 0; i < choice-1; i++)
+        temp = temp->next;
+    OwnerNode *cur = temp;
+    printf("\nEntering %s's Pokedex...\n", cur->ownerName);
+
+    int subChoice;
     do
     {
-        printf("\n=== Main Menu ===\n");
-        printf("1. New Pokedex\n");
-        printf("2. Existing Pokedex\n");
-        printf("3. Delete a Pokedex\n");
-        printf("4. Merge Pokedexes\n");
-        printf("5. Sort Owners by Name\n");
-        printf("6. Print Owners in a direction X times\n");
-        printf("7. Exit\n");
-        choice = readIntSafe("Your choice: ");
+        printf("\n-- %s's Pokedex Menu --\n", cur->ownerName);
+        printf("1. Add Pokemon\n");
+        printf("2. Display Pokedex\n");
+        printf("3. Release Pokemon (by ID)\n");
+        printf("4. Pokemon Fight!\n");
+        printf("5. Evolve Pokemon\n");
+        printf("6. Back to Main\n");
+        printf("7. Switch Storage (Tree/Bitset)\n");
+        printf("8. Team Summary\n");
 
-        switch (choice)
+        subChoice = readIntSafe("Your choice: ");
+
+        //menu number -> timed action (-1: not an action)
+        static const int subActions[] = { -1, ACTION_ADD, ACTION_DISPLAY, ACTION_RELEASE,
+                                          ACTION_FIGHT, ACTION_EVOLVE, -1, ACTION_STORAGE,
+                                          ACTION_TEAM };
+        ActionTimer timer;
+        actionStart(&timer);
+        switch (subChoice)
         {
         case 1:
-            printf("Your name: ");
-            char *name = getDynamicInput();
-            //check for duplicates
-            int isDup = 0;
-            OwnerNode *temp = ownerHead;
-            for(int i = 0; i < numOfPokedexes; i++) {
-                if(temp != NULL && strcmp(name, temp->ownerName) == 0) {
-                    printf("Owner '%s' already exists. Not creating a new Pokedex.\n", name);
-                    free(name);
-                    isDup = 1;
-                    break;
-                }
-                temp = temp->next;
-            }
-            if(!isDup) {
-                openPokedexMenu(name);
-                numOfPokedexes++;
-            }
+            addPokemon(cur);
             break;
         case 2:
-            enterExistingPokedexMenu(numOfPokedexes);
+            displayMenu(cur);
             break;
         case 3:
-            if(ownerHead == NULL) {
-                printf("No existing Pokedexes to delete.\n");
+            if(cur->pokemonCount == 0) {
+                printf("No Pokemon to release.\n");
                 break;
             }
-            deletePokedex(numOfPokedexes);
-            numOfPokedexes--;
+            freePokemon(cur);
             break;
         case 4:
-            if(!ownerHead || ownerHead == ownerHead->next) {
-                printf("Not enough owners to merge.\n");
-                break;
-            }
-            mergePokedexMenu(numOfPokedexes);
-            numOfPokedexes--;
+            pokemonFight(cur);
             break;
         case 5:
-            if(ownerHead == NULL || ownerHead == ownerHead->next) {
-                printf("0 or 1 owners only => no need to sort.\n");
-                break;
-            }
-            sortOwners(numOfPokedexes);
+            evolvePokemon(cur);
             break;
         case 6:
-            if(ownerHead == NULL) {
-                printf("No owners.\n");
-                break;
-            }
-            printOwnersCircular();
+            printf("Back to Main Menu.\n");
             break;
         case 7:
-            if (numOfPokedexes > 0) {
-                freeAllOwners(numOfPokedexes);
-            }
-            printf("Goodbye!\n");
+            cur->storageLocked = 1;
+            setPokedexStorage(cur, cur->storage == STORAGE_TREE ? STORAGE_BITSET : STORAGE_TREE);
+            journalRecord(JOURNAL_STORAGE, cur->ownerName, NULL, cur->storage);
+            printf("%s's Pokedex is now stored as a %s.\n", cur->ownerName,
+                   cur->storage == STORAGE_TREE ? "tree" : "bitset");
+            break;
+        case 8:
+            teamSummary(cur);
             break;
         default:
-            printf("Invalid.\n");
+            printf("Invalid choice.\n");
         }
-    } while (choice != 7);
+        if (subChoice >= 1 && subChoice <= 8 && subActions[subChoice] >= 0)
+            actionEnd(&timer, (MenuAction)subActions[subChoice]);
+    } while (subChoice != 6);
 }
 
-int main()
-{
-    mainMenu();
+void deletePokedex(int n) {
+    printf("\n=== Delete a Pokedex ===\n");
+    OwnerNode *temp = ownerHead;
+    for (int i = 0; i < n; i++) {
+        printf("%d. %s\n", i + 1, temp->ownerName);
+        temp = temp->next;
+    }
+    int choice = readIntSafe("Choose a Pokedex to delete by number: ");
+
+    //navigate to the node to delete
+    for(int i = 0; i < choice-1; i++)
+        temp = temp->next;
+
+    printf("Deleting %s's entire Pokedex...\nPokedex deleted.", temp->ownerName);
+    journalRecord(JOURNAL_DELETE, temp->ownerName, NULL, 0);
+
+    removeOwnerFromCircularList(temp);
+}
+
+void mergePokedexMenu(int n) {
+    printf("\n=== Merge Pokedexes ===\n");
+    printf("Enter name of first owner: ");
+    char* firstName = getDynamicInput();
+    printf("Enter name of second owner: ");
+    char* secondName = getDynamicInput();
+
+    (void)n;
+    OwnerNode *first = findOwnerByName(firstName);
+    OwnerNode *second = findOwnerByName(secondName);
+    if(!first || !second || first == second) {
+        printf("One or both owners not found.\n");
+        exFree(firstName);
+        exFree(secondName);
+        return;
+    }
+
+    printf("Merging %s and %s...\n", firstName, secondName);
+    int dropped[POKEDEX_SIZE];
+    int numDropped = mergePokedexes(first, second, dropped);
+    journalRecord(JOURNAL_MERGE, firstName, secondName, 0);
+    for(int i = 0; i < numDropped; i++)
+        printf("Duplicate %s (ID %d) dropped.\n", pokedex[dropped[i] - 1].name, dropped[i]);
+
+    removeOwnerFromCircularList(second);
+
+    printf("Merge completed.\n");
+    printf("Owner '%s' has been removed after merging.\n", secondName);
+    exFree(firstName);
+    exFree(secondName);
+}
+
+uint64_t computeNamePrefix(const char *name) {
+    //first 8 bytes, big-endian and zero padded, so integer order == strcmp order
+    uint64_t prefix = 0;
+    int i = 0;
+    for (; i < 8 && name[i]; i++)
+        prefix = (prefix << 8) | (unsigned char)name[i];
+    for (; i < 8; i++)
+        prefix <<= 8;
+    return prefix;
+}
+
+static int compareOwners(const OwnerNode *a, const OwnerNode *b) {
+    if (a->namePrefix != b->namePrefix)
+        return a->namePrefix < b->namePrefix ? -1 : 1;
+    return strcmp(a->ownerName, b->ownerName);
+}
+
+//stable merge of two NULL-terminated runs linked through ->next
+static OwnerNode *mergeOwnerRuns(OwnerNode *a, OwnerNode *b) {
+    OwnerNode head;
+    OwnerNode *tail = &head;
+    while (a != NULL && b != NULL) {
+        if (compareOwners(b, a) < 0) {
+            tail->next = b;
+            b = b->next;
+        }
+        else {
+            tail->next = a;
+            a = a->next;
+        }
+        tail = tail->next;
+    }
+    tail->next = a != NULL ? a : b;
+    return head.next;
+}
+
+void sortOwnerRing(void) {
+    if (ownerHead == NULL)
+        return;
+    //open the ring into a NULL-terminated list
+    ownerHead->prev->next = NULL;
+
+    //bottom-up: merge runs of width 1, 2, 4, ... until one run is left
+    OwnerNode *list = ownerHead;
+    for (int width = 1; ; width *= 2) {
+        OwnerNode head;
+        head.next = NULL;
+        OwnerNode *tail = &head;
+        OwnerNode *rest = list;
+        int merges = 0;
+        while (rest != NULL) {
+            OwnerNode *a = rest, *b = NULL;
+            int i;
+            for (i = 1; i < width && rest->next != NULL; i++)
+                rest = rest->next;
+            b = rest->next;
+            rest->next = NULL;
+            rest = b;
+            if (b != NULL) {
+                for (i = 1; i < width && rest->next != NULL; i++)
+                    rest = rest->next;
+                OwnerNode *after = rest->next;
+                rest->next = NULL;
+                rest = after;
+            }
+            tail->next = mergeOwnerRuns(a, b);
+            while (tail->next != NULL)
+                tail = tail->next;
+            merges++;
+        }
+        list = head.next;
+        if (merges <= 1)
+            break;
+    }
+
+    //restore prev links and close the ring
+    OwnerNode *prev = list;
+    for (OwnerNode *cur = list->next; cur != NULL; cur = cur->next) {
+        cur->prev = prev;
+        prev = cur;
+    }
+    prev->next = list;
+    list->prev = prev;
+    ownerHead = list;
+}
+
+void sortOwners(int n) {
+    (void)n;
+    sortOwnerRing();
+    journalRecord(JOURNAL_SORT, NULL, NULL, 0);
+    printf("Owners sorted by name.\n");
+}
+
+void printOwnersCircular() {
+    printf("Enter direction (F or B): ");
+    char *direction = getDynamicInput();
+    int amount = readIntSafe("How many prints? ");
+    OwnerNode *temp = ownerHead;
+    int forward = (*direction == 'f' || *direction == 'F');
+    int backward = (*direction == 'b' || *direction == 'B');
+    outBeginBatch();
+    for(int i = 0; (forward || backward) && i < amount; i++) {
+        outPutChars("[", 1);
+        outPutInt(i+1);
+        outPutChars("] ", 2);
+        outPutStr(temp->ownerName);
+        outPutChars("\n", 1);
+        temp = forward ? temp->next : temp->prev;
+    }
+    outEndBatch();
+    exFree(direction);
+}
+
+void showSpeciesHolders(void) {
+    int id = readIntSafe("Enter Pokemon ID: ");
+    if (id < 1 || id > POKEDEX_SIZE) {
+        printf("Invalid ID.\n");
+        return;
+    }
+    int count;
+    OwnerNode *const *holders = speciesHolders(id, &count);
+    if (count == 0) {
+        printf("No owner has %s (ID %d).\n", pokedex[id - 1].name, id);
+        return;
+    }
+    printf("%s (ID %d) is owned by %d of %d owners:\n", pokedex[id - 1].name, id, count, ownerIndex.count);
+    outBeginBatch();
+    for (int i = 0; i < count; i++) {
+        outPutChars("- ", 2);
+        outPutStr(holders[i]->ownerName);
+        outPutChars("\n", 1);
+    }
+    outEndBatch();
+}
+
+OwnerNode *createOwner(char *ownerName, int starterId) {
+    OwnerNode *owner = exMalloc(sizeof(OwnerNode), MEM_OWNERS);
+    if (!owner) {
+        printf("Memory allocation failed.\n");
+        return NULL;
+    }
+    owner->ownerName = ownerName;
+    owner->namePrefix = computeNamePrefix(ownerName);
+    owner->pokedexRoot = NULL;
+    owner->pool.slabs = NULL;
+    owner->pool.freeList = NULL;
+    owner->storage = storagePolicy == STORAGE_BITSET ? STORAGE_BITSET : STORAGE_TREE;
+    owner->storageLocked = 0;
+    memset(owner->bits, 0, sizeof(owner->bits));
+    owner->pokemonCount = 0;
+    //all -1: holds nothing yet
+    memset(owner->speciesSlot, 0xff, sizeof(owner->speciesSlot));
+    memset(owner->typeCounts, 0, sizeof(owner->typeCounts));
+    owner->totalHp = 0;
+    owner->totalAttack = 0;
+
+    //0 means no starter; anything else has to be a real, addable ID
+    if (starterId != 0 && !pokedexAdd(owner, starterId)) {
+        poolRelease(&owner->pool);
+        exFree(owner);
+        return NULL;
+    }
+    if (!linkOwnerInCircularList(owner)) {
+        speciesIndexDropOwner(owner);
+        poolRelease(&owner->pool);
+        exFree(owner);
+        return NULL;
+    }
+    return owner;
+}
+
+void openPokedexMenu( char *name) {
+    printf("Choose Starter:\n1. Bulbasaur\n2. Charmander\n3. Squirtle\n");
+    int choice = readIntSafe("Your choice: ");
+    if (choice < 1 || choice > 3) {
+        printf("Invalid choice.\n");
+        exFree(name);
+        return;
+    }
+    int starterId = (choice-1)*3 + 1;
+
+    OwnerNode *newPokedex = createOwner(name, starterId);
+    if (!newPokedex) {
+        exFree(name);
+        return;
+    }
+    journalRecord(JOURNAL_CREATE, name, NULL, starterId);
+    printf("New Pokedex created for %s with starter %s.\n", newPokedex->ownerName,
+                                                        pokedex[starterId - 1].name);
+}
+
+
+// --------------------------------------------------------------
+// Main Menu
+// --------------------------------------------------------------
+void mainMenu()
+{
+    int choice, numOfPokedexes = ownerIndex.count;
+    do
+    {
+        printf("\n=== Main Menu ===\n");
+        printf("1. New Pokedex\n");
+        printf("2. Existing Pokedex\n");
+        printf("3. Delete a Pokedex\n");
+        printf("4. Merge Pokedexes\n");
+        printf("5. Sort Owners by Name\n");
+        printf("6. Print Owners in a direction X times\n");
+        printf("7. Exit\n");
+        printf("8. Save Snapshot\n");
+        printf("9. Statistics\n");
+        printf("10. Who Owns a Pokemon\n");
+        printf("11. Find Pokemon by Type\n");
+        printf("12. Leaderboard\n");
+        choice = readIntSafe("Your choice: ");
+
+        static const int mainActions[] = { -1, ACTION_NEW, -1, ACTION_DELETE, ACTION_MERGE,
+                                           ACTION_SORT, ACTION_PRINT, -1, ACTION_SAVE, -1, ACTION_HOLDERS,
+                                           ACTION_BY_TYPE, ACTION_LEADERBOARD };
+        ActionTimer timer;
+        actionStart(&timer);
+        switch (choice)
+        {
+        case 1:
+            printf("Your name: ");
+            char *name = getDynamicInput();
+            //check for duplicates
+            if(findOwnerByName(name) != NULL) {
+                printf("Owner '%s' already exists. Not creating a new Pokedex.\n", name);
+                exFree(name);
+                break;
+            }
+            openPokedexMenu(name);
+            numOfPokedexes = ownerIndex.count;
+            break;
+        case 2:
+            enterExistingPokedexMenu(numOfPokedexes);
+            break;
+        case 3:
+            if(ownerHead == NULL) {
+                printf("No existing Pokedexes to delete.\n");
+                break;
+            }
+            deletePokedex(numOfPokedexes);
+            numOfPokedexes--;
+            break;
+        case 4:
+            if(!ownerHead || ownerHead == ownerHead->next) {
+                printf("Not enough owners to merge.\n");
+                break;
+            }
+            mergePokedexMenu(numOfPokedexes);
+            numOfPokedexes = ownerIndex.count;
+            break;
+        case 5:
+            if(ownerHead == NULL || ownerHead == ownerHead->next) {
+                printf("0 or 1 owners only => no need to sort.\n");
+                break;
+            }
+            sortOwners(numOfPokedexes);
+            break;
+        case 6:
+            if(ownerHead == NULL) {
+                printf("No owners.\n");
+                break;
+            }
+            printOwnersCircular();
+            break;
+        case 7:
+            if (snapshotPath != NULL && !checkpointSnapshot(snapshotPath))
+                printf("Could not save snapshot to %s.\n", snapshotPath);
+            freeAllOwners(numOfPokedexes);
+            printf("Goodbye!\n");
+            break;
+        case 8: {
+            printf("Snapshot file: ");
+            char *path = getDynamicInput();
+            if (path == NULL)
+                break;
+            if (checkpointSnapshot(path))
+                printf("Saved %d owners to %s.\n", numOfPokedexes, path);
+            else
+                printf("Could not save snapshot to %s.\n", path);
+            exFree(path);
+            break;
+        }
+        case 9:
+            printStatistics(stdout);
+            break;
+        case 10:
+            showSpeciesHolders();
+            break;
+        case 11:
+            showTypeHolders();
+            break;
+        case 12:
+            showLeaderboard();
+            break;
+        default:
+            printf("Invalid.\n");
+        }
+        if (choice >= 1 && choice <= 12 && mainActions[choice] >= 0)
+            actionEnd(&timer, (MenuAction)mainActions[choice]);
+    } while (choice != 7);
+}
+
+// --------------------------------------------------------------
+// Statistics
+// --------------------------------------------------------------
+void recordTreeOp(TreeOp op, int depth) {
+    opStats.tree[op].calls++;
+    if (depth > opStats.tree[op].maxDepth)
+        opStats.tree[op].maxDepth = depth;
+}
+
+void actionStart(ActionTimer *timer) {
+    timer->heapAllocs = opStats.heapAllocs;
+    timer->nodeAllocs = opStats.nodeAllocs;
+    timer->inputWaitNs = opStats.inputWaitNs;
+    timer->start = nowNs();
+}
+
+void actionEnd(ActionTimer *timer, MenuAction action) {
+    uint64_t elapsed = nowNs() - timer->start;
+    uint64_t waited = opStats.inputWaitNs - timer->inputWaitNs;
+    uint64_t ns = elapsed > waited ? elapsed - waited : 0;
+    ActionStats *st = &opStats.action[action];
+    //bucket b holds latencies in [2^b, 2^(b+1)) ns
+    int bucket = 0;
+    while (bucket < LATENCY_BUCKETS - 1 && (ns >> (bucket + 1)) != 0)
+        bucket++;
+    st->buckets[bucket]++;
+    st->calls++;
+    st->totalNs += ns;
+    st->heapAllocs += opStats.heapAllocs - timer->heapAllocs;
+    st->nodeAllocs += opStats.nodeAllocs - timer->nodeAllocs;
+}
+
+static const char *actionNames[ACTION_COUNT] = {
+    "new pokedex", "add", "display", "release", "fight", "evolve", "switch storage",
+    "delete pokedex", "merge", "sort owners", "print owners", "save snapshot", "who owns",
+    "by type", "team summary", "leaderboard"
+};
+
+static const char *treeOpNames[TREE_OP_COUNT] = { "search", "insert", "remove" };
+
+//upper bound (ns) of the bucket holding the given fraction of the calls
+static uint64_t bucketPercentile(const ActionStats *st, double fraction) {
+    uint64_t want = (uint64_t)(fraction * (double)st->calls);
+    uint64_t seen = 0;
+    for (int b = 0; b < LATENCY_BUCKETS; b++) {
+        seen += st->buckets[b];
+        if (seen > want)
+            return (uint64_t)2 << b;
+    }
+    return (uint64_t)2 << (LATENCY_BUCKETS - 1);
+}
+
+void printStatistics(FILE *out) {
+    fprintf(out, "\n=== Statistics ===\n");
+    fprintf(out, "%-8s %12s %10s %10s\n", "tree op", "calls", "nodes/op", "max depth");
+    for (int i = 0; i < TREE_OP_COUNT; i++) {
+        const TreeOpStats *t = &opStats.tree[i];
+        fprintf(out, "%-8s %12llu %10.2f %10d\n", treeOpNames[i], (unsigned long long)t->calls,
+                t->calls ? (double)t->nodesTouched / (double)t->calls : 0.0, t->maxDepth);
+    }
+    fprintf(out, "%-15s %9s %10s %10s %10s %10s %10s\n", "action", "calls", "avg ns",
+            "p50 <= ns", "p99 <= ns", "allocs/op", "nodes/op");
+    for (int i = 0; i < ACTION_COUNT; i++) {
+        const ActionStats *a = &opStats.action[i];
+        if (a->calls == 0)
+            continue;
+        fprintf(out, "%-15s %9llu %10llu %10llu %10llu %10.2f %10.2f\n", actionNames[i],
+                (unsigned long long)a->calls, (unsigned long long)(a->totalNs / a->calls),
+                (unsigned long long)bucketPercentile(a, 0.5), (unsigned long long)bucketPercentile(a, 0.99),
+                (double)a->heapAllocs / (double)a->calls, (double)a->nodeAllocs / (double)a->calls);
+    }
+    fprintf(out, "Latency histograms (calls per [2^k, 2^(k+1)) ns bucket):\n");
+    for (int i = 0; i < ACTION_COUNT; i++) {
+        const ActionStats *a = &opStats.action[i];
+        if (a->calls == 0)
+            continue;
+        fprintf(out, "  %-15s", actionNames[i]);
+        for (int b = 0; b < LATENCY_BUCKETS; b++) {
+            if (a->buckets[b] != 0)
+                fprintf(out, " 2^%d:%llu", b, (unsigned long long)a->buckets[b]);
+        }
+        fprintf(out, "\n");
+    }
+    fprintf(out, "Heap allocations: %llu, pool nodes handed out: %llu\n",
+            (unsigned long long)opStats.heapAllocs, (unsigned long long)opStats.nodeAllocs);
+#if defined(TRACK_ALLOC)
+    memoryReport(out, 0);
+#endif
+}
+
+#if defined(TRACK_ALLOC)
+// --------------------------------------------------------------
+// Tracking allocator
+// --------------------------------------------------------------
+// Every block carries a header on a doubly linked live list.
+typedef struct MemBlock {
+    struct MemBlock *prev;
+    struct MemBlock *next;
+    size_t size;
+    int kind;
+    int line;
+} MemBlock;
+
+// keeps the payload after the header suitably aligned
+typedef union MemHeader {
+    MemBlock block;
+    long double align;
+} MemHeader;
+
+static struct {
+    MemBlock *live;
+    size_t liveBytes[MEM_KIND_COUNT];
+    size_t liveBlocks[MEM_KIND_COUNT];
+    size_t peakBytes[MEM_KIND_COUNT];
+    size_t totalBytes;
+    size_t peakTotal;
+} memTrack;
+
+static const char *memKindNames[MEM_KIND_COUNT] = { "owners", "nodes", "data", "queues", "names" };
+
+static void memLink(MemBlock *b) {
+    b->prev = NULL;
+    b->next = memTrack.live;
+    if (memTrack.live != NULL)
+        memTrack.live->prev = b;
+    memTrack.live = b;
+}
+
+static void memUnlink(MemBlock *b) {
+    if (b->prev != NULL)
+        b->prev->next = b->next;
+    else
+        memTrack.live = b->next;
+    if (b->next != NULL)
+        b->next->prev = b->prev;
+}
+
+static void memCount(int kind, size_t size, int sign) {
+    if (sign > 0) {
+        memTrack.liveBytes[kind] += size;
+        memTrack.liveBlocks[kind]++;
+        memTrack.totalBytes += size;
+        if (memTrack.liveBytes[kind] > memTrack.peakBytes[kind])
+            memTrack.peakBytes[kind] = memTrack.liveBytes[kind];
+        if (memTrack.totalBytes > memTrack.peakTotal)
+            memTrack.peakTotal = memTrack.totalBytes;
+    }
+    else {
+        memTrack.liveBytes[kind] -= size;
+        memTrack.liveBlocks[kind]--;
+        memTrack.totalBytes -= size;
+    }
+}
+
+void *trackMalloc(size_t size, MemKind kind, int line) {
+    MemHeader *h = (MemHeader *)malloc(sizeof(MemHeader) + size);
+    if (h == NULL)
+        return NULL;
+    h->block.size = size;
+    h->block.kind = kind;
+    h->block.line = line;
+    memLink(&h->block);
+    memCount(kind, size, 1);
+    return h + 1;
+}
+
+void *trackCalloc(size_t count, size_t size, MemKind kind, int line) {
+    if (size != 0 && count > ((size_t)-1 - sizeof(MemHeader)) / size)
+        return NULL;
+    void *p = trackMalloc(count * size, kind, line);
+    if (p != NULL)
+        memset(p, 0, count * size);
+    return p;
+}
+
+void *trackRealloc(void *ptr, size_t size, MemKind kind, int line) {
+    if (ptr == NULL)
+        return trackMalloc(size, kind, line);
+    MemHeader *old = (MemHeader *)ptr - 1;
+    size_t oldSize = old->block.size;
+    int oldKind = old->block.kind;
+    MemHeader *h = (MemHeader *)realloc(old, sizeof(MemHeader) + size);
+    if (h == NULL)
+        return NULL;
+    //the block may have moved: repoint its neighbours
+    if (h->block.prev != NULL)
+        h->block.prev->next = &h->block;
+    else
+        memTrack.live = &h->block;
+    if (h->block.next != NULL)
+        h->block.next->prev = &h->block;
+    memCount(oldKind, oldSize, -1);
+    h->block.size = size;
+    h->block.kind = kind;
+    h->block.line = line;
+    memCount(kind, size, 1);
+    return h + 1;
+}
+
+void trackFree(void *ptr) {
+    if (ptr == NULL)
+        return;
+    MemHeader *h = (MemHeader *)ptr - 1;
+    memUnlink(&h->block);
+    memCount(h->block.kind, h->block.size, -1);
+    free(h);
+}
+
+void memoryReport(FILE *out, int listBlocks) {
+    fprintf(out, "\n=== Memory ===\n");
+    fprintf(out, "%-8s %12s %8s %12s\n", "kind", "live bytes", "blocks", "peak bytes");
+    for (int k = 0; k < MEM_KIND_COUNT; k++)
+        fprintf(out, "%-8s %12zu %8zu %12zu\n", memKindNames[k], memTrack.liveBytes[k],
+                memTrack.liveBlocks[k], memTrack.peakBytes[k]);
+    fprintf(out, "Live: %zu bytes, high-water mark: %zu bytes\n", memTrack.totalBytes, memTrack.peakTotal);
+    if (!listBlocks || memTrack.live == NULL)
+        return;
+    //group by call site; a line allocates one kind, so the line is the key
+    fprintf(out, "Unfreed blocks by call site:\n");
+    int lastLine = 0;
+    for (;;) {
+        int line = 0;
+        for (MemBlock *b = memTrack.live; b != NULL; b = b->next) {
+            if (b->line > lastLine && (line == 0 || b->line < line))
+                line = b->line;
+        }
+        if (line == 0)
+            break;
+        size_t blocks = 0, bytes = 0;
+        int kind = 0;
+        for (MemBlock *b = memTrack.live; b != NULL; b = b->next) {
+            if (b->line == line) {
+                blocks++;
+                bytes += b->size;
+                kind = b->kind;
+            }
+        }
+        fprintf(out, "  ex6.c:%d (%s): %zu blocks, %zu bytes\n", line, memKindNames[kind], blocks, bytes);
+        lastLine = line;
+    }
+}
+#endif
+
+// --------------------------------------------------------------
+// Snapshots
+// --------------------------------------------------------------
+// Layout (all integers little-endian):
+//   header   "PKDX", u32 version, u32 owner count, u32 name bytes
+//   owners   u32 name offset, u32 name length, u8 count, u8 flags, u16 reserved
+//   names    every owner name back to back, no terminators
+//   ids      each owner's IDs ascending, one byte each (IDs never exceed 151)
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_HEADER 16
+#define SNAPSHOT_RECORD 12
+#define SNAPSHOT_BITSET 1
+#define SNAPSHOT_LOCKED 2
+
+static void putU32(unsigned char *p, uint32_t v) {
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+    p[2] = (unsigned char)(v >> 16);
+    p[3] = (unsigned char)(v >> 24);
+}
+
+static uint32_t getU32(const unsigned char *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+//ascending IDs of one owner, whatever its storage
+static int ownerIds(OwnerNode *owner, int *ids) {
+    if (owner->storage == STORAGE_BITSET)
+        return bitsetToIds(owner->bits, ids);
+    PokemonNode *nodes[POKEDEX_SIZE];
+    int n = collectInOrder(owner->pokedexRoot, nodes);
+    for (int i = 0; i < n; i++)
+        ids[i] = nodes[i]->data->id;
+    return n;
+}
+
+//make a rename in path's directory durable
+static int syncParentDir(const char *path) {
+#if defined(_WIN32)
+    (void)path;
+    return 1;
+#else
+    const char *slash = strrchr(path, '/');
+    char *dir = NULL;
+    if (slash != NULL) {
+        size_t len = slash == path ? 1 : (size_t)(slash - path);
+        dir = exMalloc(len + 1, MEM_DATA);
+        if (!dir)
+            return 0;
+        memcpy(dir, path, len);
+        dir[len] = '\0';
+    }
+    int fd = open(dir ? dir : ".", O_RDONLY);
+    exFree(dir);
+    if (fd < 0)
+        return 0;
+    int ok = fsync(fd) == 0;
+    close(fd);
+    return ok;
+#endif
+}
+
+int saveSnapshot(const char *path) {
+    int owners = ownerIndex.count;
+    size_t nameBytes = 0, idBytes = 0;
+    OwnerNode *cur = ownerHead;
+    for (int i = 0; i < owners; i++, cur = cur->next) {
+        nameBytes += strlen(cur->ownerName);
+        idBytes += (size_t)cur->pokemonCount;
+    }
+    size_t size = SNAPSHOT_HEADER + (size_t)owners * SNAPSHOT_RECORD + nameBytes + idBytes;
+    unsigned char *buf = exMalloc(size, MEM_DATA);
+    if (!buf) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        return 0;
+    }
+    memcpy(buf, "PKDX", 4);
+    putU32(buf + 4, SNAPSHOT_VERSION);
+    putU32(buf + 8, (uint32_t)owners);
+    putU32(buf + 12, (uint32_t)nameBytes);
+
+    unsigned char *record = buf + SNAPSHOT_HEADER;
+    unsigned char *names = record + (size_t)owners * SNAPSHOT_RECORD;
+    unsigned char *idOut = names + nameBytes;
+    size_t nameAt = 0;
+    cur = ownerHead;
+    for (int i = 0; i < owners; i++, cur = cur->next, record += SNAPSHOT_RECORD) {
+        int ids[POKEDEX_SIZE];
+        size_t len = strlen(cur->ownerName);
+        int n = ownerIds(cur, ids);
+        putU32(record, (uint32_t)nameAt);
+        putU32(record + 4, (uint32_t)len);
+        record[8] = (unsigned char)n;
+        record[9] = (unsigned char)((cur->storage == STORAGE_BITSET ? SNAPSHOT_BITSET : 0) |
+                                    (cur->storageLocked ? SNAPSHOT_LOCKED : 0));
+        record[10] = record[11] = 0;
+        memcpy(names + nameAt, cur->ownerName, len);
+        nameAt += len;
+        for (int k = 0; k < n; k++)
+            *idOut++ = (unsigned char)ids[k];
+    }
+
+    //write and sync a sibling file, rename it, then sync the directory, so a crash
+    //leaves either the old snapshot or the whole new one before the journal is emptied
+    size_t pathLen = strlen(path);
+    char *tmp = exMalloc(pathLen + 5, MEM_DATA);
+    if (!tmp) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        exFree(buf);
+        return 0;
+    }
+    memcpy(tmp, path, pathLen);
+    memcpy(tmp + pathLen, ".tmp", 5);
+    FILE *f = fopen(tmp, "wb");
+    int ok = f != NULL && fwrite(buf, 1, size, f) == size && fflush(f) == 0;
+#if !defined(_WIN32)
+    if (ok && fsync(fileno(f)) != 0)
+        ok = 0;
+#endif
+    if (f != NULL && fclose(f) != 0)
+        ok = 0;
+    if (ok && rename(tmp, path) != 0) {
+        //rename can't replace an existing file everywhere
+        remove(path);
+        ok = rename(tmp, path) == 0;
+    }
+    if (ok && !syncParentDir(path))
+        ok = 0;
+    if (!ok)
+        remove(tmp);
+    exFree(tmp);
+    exFree(buf);
+    return ok;
+}
+
+static int loadSnapshotBytes(const unsigned char *data, size_t size) {
+    if (size < SNAPSHOT_HEADER || memcmp(data, "PKDX", 4) != 0 || getU32(data + 4) != SNAPSHOT_VERSION)
+        return -1;
+    size_t owners = getU32(data + 8);
+    size_t nameBytes = getU32(data + 12);
+    size_t fixed = SNAPSHOT_HEADER + owners * SNAPSHOT_RECORD + nameBytes;
+    if (owners > (size - SNAPSHOT_HEADER) / SNAPSHOT_RECORD || fixed > size)
+        return -1;
+
+    const unsigned char *record = data + SNAPSHOT_HEADER;
+    const unsigned char *names = record + owners * SNAPSHOT_RECORD;
+    const unsigned char *ids = data + fixed;
+    size_t idsLeft = size - fixed;
+    int loaded = 0;
+    for (size_t i = 0; i < owners; i++, record += SNAPSHOT_RECORD) {
+        size_t nameAt = getU32(record), len = getU32(record + 4);
+        int n = record[8];
+        if (nameAt > nameBytes || len > nameBytes - nameAt || len == 0 || (size_t)n > idsLeft || n > POKEDEX_SIZE)
+            return -1;
+        //ascending and in range, or the balanced build below would be wrong
+        for (int k = 0; k < n; k++) {
+            if (ids[k] < 1 || ids[k] > POKEDEX_SIZE || (k > 0 && ids[k] <= ids[k - 1]))
+                return -1;
+        }
+        char *name = exMalloc(len + 1, MEM_NAMES);
+        if (!name) {
+            printf("Memory allocation failed.\n");
+            return -1;
+        }
+        memcpy(name, names + nameAt, len);
+        name[len] = '\0';
+        if (memchr(name, '\0', len) != NULL || findOwnerByName(name) != NULL) {
+            exFree(name);
+            return -1;
+        }
+        OwnerNode *owner = createOwner(name, 0);
+        if (!owner) {
+            exFree(name);
+            return -1;
+        }
+        owner->storageLocked = (record[9] & SNAPSHOT_LOCKED) != 0;
+        if (record[9] & SNAPSHOT_BITSET) {
+            owner->storage = STORAGE_BITSET;
+            for (int k = 0; k < n; k++)
+                owner->bits[(ids[k] - 1) >> 6] |= (uint64_t)1 << ((ids[k] - 1) & 63);
+        }
+        else {
+            owner->storage = STORAGE_TREE;
+            PokemonNode *nodes[POKEDEX_SIZE];
+            for (int k = 0; k < n; k++) {
+                nodes[k] = createPokemonNode(&owner->pool, &pokedex[ids[k] - 1]);
+                if (!nodes[k])
+                    return -1;
+            }
+            owner->pokedexRoot = buildBalancedTree(nodes, n);
+        }
+        owner->pokemonCount = n;
+        for (int k = 0; k < n; k++) {
+            if (!speciesIndexAdd(owner, ids[k]))
+                return -1;
+        }
+        applyStoragePolicy(owner);
+        ids += n;
+        idsLeft -= (size_t)n;
+        loaded++;
+    }
+    return idsLeft == 0 ? loaded : -1;
+}
+
+int loadSnapshot(const char *path) {
+    int loaded = -1;
+#if defined(_WIN32)
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return 0;
+    unsigned char *data = NULL;
+    long size = -1;
+    if (fseek(f, 0, SEEK_END) == 0 && (size = ftell(f)) >= 0 && fseek(f, 0, SEEK_SET) == 0) {
+        data = exMalloc(size > 0 ? (size_t)size : 1, MEM_DATA);
+        if (data && fread(data, 1, (size_t)size, f) == (size_t)size)
+            loaded = loadSnapshotBytes(data, (size_t)size);
+    }
+    exFree(data);
+    fclose(f);
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return errno == ENOENT ? 0 : -1;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size >= SNAPSHOT_HEADER) {
+        void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            loaded = loadSnapshotBytes(map, (size_t)st.st_size);
+            munmap(map, (size_t)st.st_size);
+        }
+    }
+    close(fd);
+#endif
+    if (loaded < 0) {
+        //never run on half a snapshot
+        while (ownerHead != NULL)
+            removeOwnerFromCircularList(ownerHead);
+    }
+    return loaded;
+}
+
+// --------------------------------------------------------------
+// Journal
+// --------------------------------------------------------------
+// File: "PKJL", u32 version, then records of
+//   u8 op, u8 arg, u16 reserved, u32 first name length, u32 second name length,
+//   the names (no terminators), u32 FNV-1a checksum of everything before it.
+// A record that is cut short or fails its checksum ends the journal.
+#define JOURNAL_VERSION 1
+#define JOURNAL_HEADER 8
+#define JOURNAL_RECORD 12
+#define JOURNAL_GROUP 65536
+
+static struct {
+    FILE *file;
+    char *path;
+    unsigned char *pending;  // records not yet written
+    size_t len;
+    size_t capacity;
+    size_t groupBytes;       // commit once this much is pending (0: every record)
+} journal;
+
+static uint32_t journalChecksum(const unsigned char *p, size_t n) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < n; i++) {
+        h ^= p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+void journalCommit(void) {
+    if (journal.file == NULL || journal.len == 0)
+        return;
+    //one write and one sync for the whole group
+    if (fwrite(journal.pending, 1, journal.len, journal.file) != journal.len || fflush(journal.file) != 0)
+        //stderr, like the other persistence errors: batch replies may still be buffered
+        fprintf(stderr, "Could not write journal %s.\n", journal.path);
+#if !defined(_WIN32)
+    fsync(fileno(journal.file));
+#endif
+    journal.len = 0;
+}
+
+void journalRecord(JournalOp op, const char *first, const char *second, int arg) {
+    if (journal.file == NULL)
+        return;
+    size_t lenA = first ? strlen(first) : 0, lenB = second ? strlen(second) : 0;
+    size_t size = JOURNAL_RECORD + lenA + lenB + 4;
+    if (journal.len + size > journal.capacity) {
+        size_t cap = journal.capacity ? journal.capacity : 4096;
+        while (cap < journal.len + size)
+            cap *= 2;
+        unsigned char *grown = exRealloc(journal.pending, cap, MEM_DATA);
+        if (!grown) {
+            fprintf(stderr, "Memory allocation failed.\n");
+            return;
+        }
+        journal.pending = grown;
+        journal.capacity = cap;
+    }
+    unsigned char *rec = journal.pending + journal.len;
+    rec[0] = (unsigned char)op;
+    rec[1] = (unsigned char)arg;
+    rec[2] = rec[3] = 0;
+    putU32(rec + 4, (uint32_t)lenA);
+    putU32(rec + 8, (uint32_t)lenB);
+    if (lenA)
+        memcpy(rec + JOURNAL_RECORD, first, lenA);
+    if (lenB)
+        memcpy(rec + JOURNAL_RECORD + lenA, second, lenB);
+    putU32(rec + size - 4, journalChecksum(rec, size - 4));
+    journal.len += size;
+    if (journal.len >= journal.groupBytes)
+        journalCommit();
+}
+
+//name slices in a record aren't terminated; copy one out
+static char *journalName(const unsigned char *p, size_t len) {
+    char *name = exMalloc(len + 1, MEM_NAMES);
+    if (name) {
+        memcpy(name, p, len);
+        name[len] = '\0';
+    }
+    return name;
+}
+
+//redo one mutation through the same core the menus use
+static void journalApply(int op, char *first, char *second, int arg) {
+    OwnerNode *owner = first ? findOwnerByName(first) : NULL;
+    switch (op) {
+    case JOURNAL_CREATE:
+        if (owner == NULL && first != NULL) {
+            char *name = myStrdup(first);
+            if (name && !createOwner(name, arg))
+                exFree(name);
+        }
+        break;
+    case JOURNAL_DELETE:
+        removeOwnerFromCircularList(owner);
+        break;
+    case JOURNAL_ADD:
+        if (owner)
+            pokedexAdd(owner, arg);
+        break;
+    case JOURNAL_RELEASE:
+        if (owner)
+            pokedexRemove(owner, arg);
+        break;
+    case JOURNAL_EVOLVE:
+        if (owner)
+            evolvePokemonByID(owner, arg);
+        break;
+    case JOURNAL_MERGE: {
+        OwnerNode *other = second ? findOwnerByName(second) : NULL;
+        if (owner && other && owner != other) {
+            mergePokedexes(owner, other, NULL);
+            removeOwnerFromCircularList(other);
+        }
+        break;
+    }
+    case JOURNAL_SORT:
+        sortOwnerRing();
+        break;
+    case JOURNAL_STORAGE:
+        if (owner) {
+            owner->storageLocked = 1;
+            setPokedexStorage(owner, arg == STORAGE_BITSET ? STORAGE_BITSET : STORAGE_TREE);
+        }
+        break;
+    }
+}
+
+//replay the records after the header; returns how many bytes were good
+static size_t journalReplay(const unsigned char *data, size_t size, int *replayed) {
+    size_t at = JOURNAL_HEADER;
+    while (size - at >= JOURNAL_RECORD + 4) {
+        const unsigned char *rec = data + at;
+        size_t lenA = getU32(rec + 4), lenB = getU32(rec + 8);
+        size_t room = size - at - JOURNAL_RECORD - 4;
+        if (lenA > room || lenB > room - lenA)
+            break;
+        size_t recSize = JOURNAL_RECORD + lenA + lenB + 4;
+        if (getU32(rec + recSize - 4) != journalChecksum(rec, recSize - 4))
+            break;
+        char *first = lenA ? journalName(rec + JOURNAL_RECORD, lenA) : NULL;
+        char *second = lenB ? journalName(rec + JOURNAL_RECORD + lenA, lenB) : NULL;
+        journalApply(rec[0], first, second, rec[1]);
+        exFree(first);
+        exFree(second);
+        (*replayed)++;
+        at += recSize;
+    }
+    return at;
+}
+
+//(re)write the journal as just its header
+static FILE *journalStart(const char *path) {
+    unsigned char header[JOURNAL_HEADER];
+    memcpy(header, "PKJL", 4);
+    putU32(header + 4, JOURNAL_VERSION);
+    FILE *f = fopen(path, "wb");
+    if (f == NULL)
+        return NULL;
+    if (fwrite(header, 1, JOURNAL_HEADER, f) != JOURNAL_HEADER || fflush(f) != 0) {
+        fclose(f);
+        return NULL;
+    }
+#if !defined(_WIN32)
+    fsync(fileno(f));
+#endif
+    return f;
+}
+
+int journalOpen(const char *path) {
+    int replayed = 0;
+    size_t good = 0, size = 0;
+    unsigned char *data = NULL;
+    FILE *f = fopen(path, "rb");
+    if (f != NULL) {
+        long end = -1;
+        if (fseek(f, 0, SEEK_END) == 0 && (end = ftell(f)) > 0 && fseek(f, 0, SEEK_SET) == 0) {
+            size = (size_t)end;
+            data = exMalloc(size, MEM_DATA);
+            if (!data || fread(data, 1, size, f) != size)
+                replayed = -1;
+        }
+        fclose(f);
+    }
+    if (replayed == 0 && size > 0) {
+        if (size >= JOURNAL_HEADER && memcmp(data, "PKJL", 4) == 0 && getU32(data + 4) == JOURNAL_VERSION)
+            good = journalReplay(data, size, &replayed);
+        else
+            replayed = -1;
+    }
+    if (replayed < 0) {
+        //not a journal we understand: leave the file alone
+        exFree(data);
+        return -1;
+    }
+
+    exFree(data);
+    if (size == 0)
+        journal.file = journalStart(path);
+    else {
+        //cut a torn last record off in place; the good records are never rewritten
+        journal.file = fopen(path, "ab");
+        if (journal.file != NULL && good < size) {
+#if defined(_WIN32)
+            int cut = _chsize(_fileno(journal.file), (long)good) == 0;
+#else
+            int cut = ftruncate(fileno(journal.file), (off_t)good) == 0 && fsync(fileno(journal.file)) == 0;
+#endif
+            if (!cut) {
+                fclose(journal.file);
+                journal.file = NULL;
+            }
+        }
+    }
+    if (journal.file == NULL)
+        return -1;
+    journal.path = myStrdup(path);
+    journal.groupBytes = 0;
+    return replayed;
+}
+
+void journalTruncate(void) {
+    if (journal.file == NULL)
+        return;
+    //everything so far is in the snapshot now
+    journal.len = 0;
+    fclose(journal.file);
+    journal.file = journalStart(journal.path);
+    if (journal.file == NULL)
+        fprintf(stderr, "Could not reset journal %s.\n", journal.path);
+}
+
+void journalClose(void) {
+    journalCommit();
+    if (journal.file != NULL)
+        fclose(journal.file);
+    exFree(journal.pending);
+    exFree(journal.path);
+    memset(&journal, 0, sizeof(journal));
+}
+
+int checkpointSnapshot(const char *path) {
+    if (!saveSnapshot(path))
+        return 0;
+    if (snapshotPath != NULL && strcmp(path, snapshotPath) == 0)
+        journalTruncate();
+    return 1;
+}
+
+// --------------------------------------------------------------
+// Batch Mode
+// --------------------------------------------------------------
+#define BATCH_MAX_TOKENS 8
+
+//split line in place on blanks; returns the number of tokens
+static int splitTokens(char *line, char **tokens) {
+    int n = 0;
+    char *p = line;
+    while (n < BATCH_MAX_TOKENS) {
+        while (*p == ' ' || *p == '\t' || *p == '\r')
+            p++;
+        if (*p == '\0' || *p == '#')
+            break;
+        tokens[n++] = p;
+        while (*p != '\0' && *p != ' ' && *p != '\t' && *p != '\r')
+            p++;
+        if (*p == '\0')
+            break;
+        *p++ = '\0';
+    }
+    return n;
+}
+
+#define BATCH_INT_MAX 1000000
+
+//decimal int in 0..BATCH_INT_MAX with nothing trailing; 1 on success, 0 otherwise
+static int parseBatchInt(const char *s, int *value) {
+    int v = 0;
+    if (*s == '\0')
+        return 0;
+    for (; *s; s++) {
+        if (*s < '0' || *s > '9' || v > (BATCH_INT_MAX - (*s - '0')) / 10)
+            return 0;
+        v = v * 10 + (*s - '0');
+    }
+    *value = v;
+    return 1;
+}
+
+//for arguments whose own range check rejects 0: 0 on failure (no valid ID is 0)
+static int batchIntOrZero(const char *s) {
+    int value;
+    return parseBatchInt(s, &value) ? value : 0;
+}
+
+//"ok <cmd>" / "err <cmd>" followed by the given arguments
+static void batchReply(int ok, char **tokens, int count) {
+    outPutStr(ok ? "ok" : "err");
+    for (int i = 0; i < count; i++) {
+        outPutChars(" ", 1);
+        outPutStr(tokens[i]);
+    }
+}
+
+static void batchEnd(const char *reason) {
+    if (reason != NULL) {
+        outPutChars(" ", 1);
+        outPutStr(reason);
+    }
+    outPutChars("\n", 1);
+}
+
+static int dumpedSoFar;
+
+static void dumpIdVisit(PokemonNode *node) {
+    if (dumpedSoFar++ > 0)
+        outPutChars(",", 1);
+    outPutInt(node->data->id);
+}
+
+static void batchDump(OwnerNode *owner, const char *order) {
+    PokemonNode scratch[POKEDEX_SIZE];
+    PokemonNode *root = pokedexView(owner, scratch);
+    outPutChars(" ", 1);
+    outPutInt(owner->pokemonCount);
+    outPutChars(" ", 1);
+    if (root == NULL) {
+        outPutChars("-", 1);
+        return;
+    }
+    dumpedSoFar = 0;
+    if (strcmp(order, "bfs") == 0) {
+        BFSGeneric(root, dumpIdVisit);
+    }
+    else if (strcmp(order, "pre") == 0) {
+        preOrderGeneric(root, dumpIdVisit);
+    }
+    else if (strcmp(order, "post") == 0) {
+        postOrderGeneric(root, dumpIdVisit);
+    }
+    else if (strcmp(order, "alpha") == 0) {
+        PokemonNode *byRank[POKEDEX_SIZE] = { NULL };
+        walkTreeMorris(root, ORDER_IN, rankVisit, byRank);
+        for (int r = 0; r < POKEDEX_SIZE; r++) {
+            if (byRank[r] != NULL)
+                dumpIdVisit(byRank[r]);
+        }
+    }
+    else {
+        inOrderGeneric(root, dumpIdVisit);
+    }
+}
+
+static void batchTypeHolder(OwnerNode *owner, const PokemonData *p, void *ctx) {
+    (void)ctx;
+    outPutChars(" ", 1);
+    outPutStr(owner->ownerName);
+    outPutChars(":", 1);
+    outPutInt(p->id);
+}
+
+static void batchLeader(OwnerNode *owner, const PokemonData *p, void *ctx) {
+    (void)ctx;
+    outPutChars(" ", 1);
+    outPutStr(owner->ownerName);
+    outPutChars(":", 1);
+    outPutInt(p->id);
+}
+
+static MenuAction batchAction(const char *cmd) {
+    static const struct { const char *name; MenuAction action; } actions[] = {
+        { "new", ACTION_NEW }, { "add", ACTION_ADD }, { "dump", ACTION_DISPLAY },
+        { "release", ACTION_RELEASE }, { "fight", ACTION_FIGHT }, { "evolve", ACTION_EVOLVE },
+        { "storage", ACTION_STORAGE }, { "delete", ACTION_DELETE }, { "merge", ACTION_MERGE },
+        { "sort", ACTION_SORT }, { "owners", ACTION_PRINT }, { "save", ACTION_SAVE },
+        { "kth", ACTION_DISPLAY }, { "rank", ACTION_DISPLAY }, { "page", ACTION_DISPLAY },
+        { "range", ACTION_DISPLAY }, { "rangecount", ACTION_DISPLAY }, { "rangesum", ACTION_DISPLAY },
+        { "holders", ACTION_HOLDERS }, { "typeholders", ACTION_BY_TYPE },
+        { "types", ACTION_DISPLAY }, { "bytype", ACTION_DISPLAY }, { "team", ACTION_TEAM },
+        { "top", ACTION_LEADERBOARD }
+    };
+    for (size_t i = 0; i < sizeof(actions) / sizeof(actions[0]); i++) {
+        if (strcmp(cmd, actions[i].name) == 0)
+            return actions[i].action;
+    }
+    return ACTION_COUNT;
+}
+
+static void batchCommand(char **tok, int n) {
+    const char *cmd = tok[0];
+    OwnerNode *owner = (n > 1) ? findOwnerByName(tok[1]) : NULL;
+
+    if (strcmp(cmd, "new") == 0) {
+        int id = (n == 3) ? batchIntOrZero(tok[2]) : 0;
+        if (id < 1 || id > POKEDEX_SIZE) {
+            batchReply(0, tok, n);
+            batchEnd("bad-args");
+        }
+        else if (owner != NULL) {
+            batchReply(0, tok, n);
+            batchEnd("exists");
+        }
+        else {
+            char *name = myStrdup(tok[1]);
+            OwnerNode *created = name ? createOwner(name, id) : NULL;
+            if (!created)
+                exFree(name);
+            else
+                journalRecord(JOURNAL_CREATE, name, NULL, id);
+            batchReply(created != NULL, tok, n);
+            batchEnd(created ? NULL : "no-memory");
+        }
+        return;
+    }
+    if (strcmp(cmd, "save") == 0) {
+        const char *path = (n == 2) ? tok[1] : snapshotPath;
+        int saved = path != NULL && checkpointSnapshot(path);
+        batchReply(saved, tok, n);
+        if (saved) {
+            outPutChars(" ", 1);
+            outPutInt(ownerIndex.count);
+        }
+        batchEnd(saved ? NULL : path ? "io-error" : "bad-args");
+        return;
+    }
+    if (strcmp(cmd, "sort") == 0 || strcmp(cmd, "owners") == 0) {
+        if (cmd[0] == 's') {
+            sortOwnerRing();
+            journalRecord(JOURNAL_SORT, NULL, NULL, 0);
+        }
+        batchReply(1, tok, 1);
+        outPutChars(" ", 1);
+        outPutInt(ownerIndex.count);
+        OwnerNode *cur = ownerHead;
+        for (int i = 0; i < ownerIndex.count; i++, cur = cur->next) {
+            outPutChars(" ", 1);
+            outPutStr(cur->ownerName);
+        }
+        batchEnd(NULL);
+        return;
+    }
+    if (strcmp(cmd, "holders") == 0) {
+        int id = (n == 2) ? batchIntOrZero(tok[1]) : 0;
+        if (id < 1 || id > POKEDEX_SIZE) {
+            batchReply(0, tok, n);
+            batchEnd("bad-args");
+            return;
+        }
+        int count;
+        OwnerNode *const *holders = speciesHolders(id, &count);
+        batchReply(1, tok, n);
+        outPutChars(" ", 1);
+        outPutInt(count);
+        for (int i = 0; i < count; i++) {
+            outPutChars(" ", 1);
+            outPutStr(holders[i]->ownerName);
+        }
+        batchEnd(NULL);
+        return;
+    }
+
+    if (strcmp(cmd, "top") == 0) {
+        int k = (n == 2) ? batchIntOrZero(tok[1]) : 0;
+        if (k < 1) {
+            batchReply(0, tok, n);
+            batchEnd("bad-args");
+            return;
+        }
+        //the pairs are streamed, so count them first for the reply header
+        int count = 0;
+        for (int i = 0; i < POKEDEX_SIZE && count < k; i++)
+            count += speciesIndex[i].count;
+        batchReply(1, tok, n);
+        outPutChars(" ", 1);
+        outPutInt(count < k ? count : k);
+        forEachTopPokemon(k, batchLeader, NULL);
+        batchEnd(NULL);
+        return;
+    }
+    if (strcmp(cmd, "typeholders") == 0) {
+        int type = (n == 2) ? parseTypeName(tok[1]) : -1;
+        if (type < 0) {
+            batchReply(0, tok, n);
+            batchEnd("bad-args");
+            return;
+        }
+        batchReply(1, tok, n);
+        outPutChars(" ", 1);
+        outPutInt(typeHolderCount((PokemonType)type));
+        forEachOfType((PokemonType)type, batchTypeHolder, NULL);
+        batchEnd(NULL);
+        return;
+    }
+
+    int isOwnerCommand = strcmp(cmd, "add") == 0 || strcmp(cmd, "release") == 0 ||
+                         strcmp(cmd, "evolve") == 0 || strcmp(cmd, "fight") == 0 ||
+                         strcmp(cmd, "merge") == 0 || strcmp(cmd, "delete") == 0 ||
+                         strcmp(cmd, "dump") == 0 || strcmp(cmd, "storage") == 0 ||
+                         strcmp(cmd, "kth") == 0 || strcmp(cmd, "rank") == 0 ||
+                         strcmp(cmd, "page") == 0 || strcmp(cmd, "range") == 0 ||
+                         strcmp(cmd, "rangecount") == 0 || strcmp(cmd, "rangesum") == 0 ||
+                         strcmp(cmd, "types") == 0 || strcmp(cmd, "bytype") == 0 ||
+                         strcmp(cmd, "team") == 0;
+    if (!isOwnerCommand) {
+        batchReply(0, tok, 1);
+        batchEnd("unknown-command");
+        return;
+    }
+    if (n < 2) {
+        batchReply(0, tok, n);
+        batchEnd("bad-args");
+        return;
+    }
+    if (owner == NULL) {
+        batchReply(0, tok, n);
+        batchEnd("no-owner");
+        return;
+    }
+
+    if (strcmp(cmd, "add") == 0 || strcmp(cmd, "release") == 0) {
+        int id = (n == 3) ? batchIntOrZero(tok[2]) : 0;
+        if (id < 1 || id > POKEDEX_SIZE) {
+            batchReply(0, tok, n);
+            batchEnd("bad-id");
+        }
+        else if (cmd[0] == 'a') {
+            int done = pokedexAdd(owner, id);
+            if (done)
+                journalRecord(JOURNAL_ADD, owner->ownerName, NULL, id);
+            batchReply(done, tok, n);
+            batchEnd(done ? NULL : pokedexFind(owner, id) ? "duplicate" : "no-memory");
+        }
+        else {
+            int done = pokedexRemove(owner, id);
+            if (done)
+                journalRecord(JOURNAL_RELEASE, owner->ownerName, NULL, id);
+            batchReply(done, tok, n);
+            batchEnd(done ? NULL : "not-found");
+        }
+    }
+    else if (strcmp(cmd, "evolve") == 0) {
+        int id = (n == 3) ? batchIntOrZero(tok[2]) : 0;
+        EvolveResult result = (id >= 1 && id <= POKEDEX_SIZE) ? evolvePokemonByID(owner, id) : EVOLVE_NOT_FOUND;
+        if (result == EVOLVE_DONE || result == EVOLVE_RELEASED)
+            journalRecord(JOURNAL_EVOLVE, owner->ownerName, NULL, id);
+        batchReply(result == EVOLVE_DONE || result == EVOLVE_RELEASED, tok, n);
+        if (result == EVOLVE_DONE) {
+            outPutChars(" ", 1);
+            outPutInt(id + 1);
+            batchEnd(NULL);
+        }
+        else if (result == EVOLVE_RELEASED) {
+            batchEnd("released");
+        }
+        else {
+            batchEnd(result == EVOLVE_NOT_FOUND ? "not-found" :
+                     result == EVOLVE_NO_MEMORY ? "no-memory" : "cannot-evolve");
+        }
+    }
+    else if (strcmp(cmd, "fight") == 0) {
+        const PokemonData *a = (n == 4) ? pokedexFind(owner, batchIntOrZero(tok[2])) : NULL;
+        const PokemonData *b = (n == 4) ? pokedexFind(owner, batchIntOrZero(tok[3])) : NULL;
+        batchReply(a && b, tok, n);
+        if (!a || !b) {
+            batchEnd("not-found");
+            return;
+        }
+        double diff = pokemonScore(a) - pokemonScore(b);
+        if (diff == 0.0) {
+            batchEnd("tie");
+            return;
+        }
+        outPutChars(" ", 1);
+        outPutInt(diff > 0.0 ? a->id : b->id);
+        batchEnd(NULL);
+    }
+    else if (strcmp(cmd, "merge") == 0) {
+        OwnerNode *second = (n == 3) ? findOwnerByName(tok[2]) : NULL;
+        if (second == NULL || second == owner) {
+            batchReply(0, tok, n);
+            batchEnd(n == 3 ? "no-owner" : "bad-args");
+            return;
+        }
+        int dropped = mergePokedexes(owner, second, NULL);
+        journalRecord(JOURNAL_MERGE, owner->ownerName, second->ownerName, 0);
+        removeOwnerFromCircularList(second);
+        batchReply(1, tok, n);
+        outPutChars(" ", 1);
+        outPutInt(dropped);
+        batchEnd(NULL);
+    }
+    else if (strcmp(cmd, "delete") == 0) {
+        batchReply(1, tok, n);
+        journalRecord(JOURNAL_DELETE, owner->ownerName, NULL, 0);
+        removeOwnerFromCircularList(owner);
+        batchEnd(NULL);
+    }
+    else if (strcmp(cmd, "kth") == 0 || strcmp(cmd, "rank") == 0) {
+        int arg;
+        //k counts from 1, rank takes a species ID
+        if (n != 3 || !parseBatchInt(tok[2], &arg) || arg < 1 || (cmd[0] == 'r' && arg > POKEDEX_SIZE)) {
+            batchReply(0, tok, n);
+            batchEnd("bad-args");
+            return;
+        }
+        int result = 0;
+        if (cmd[0] == 'k') {
+            const PokemonData *p = pokedexKth(owner, arg);
+            result = p ? p->id : 0;
+        }
+        else {
+            result = pokedexRank(owner, arg);
+        }
+        batchReply(result != 0, tok, n);
+        if (result == 0) {
+            batchEnd("not-found");
+            return;
+        }
+        outPutChars(" ", 1);
+        outPutInt(result);
+        batchEnd(NULL);
+    }
+    else if (strcmp(cmd, "page") == 0) {
+        const PokemonData *entries[POKEDEX_SIZE];
+        int page, pageSize;
+        if (n != 4 || !parseBatchInt(tok[2], &page) || !parseBatchInt(tok[3], &pageSize) || page < 1 || pageSize < 1) {
+            batchReply(0, tok, n);
+            batchEnd("bad-args");
+            return;
+        }
+        int count = pokedexPage(owner, page, pageSize, entries);
+        batchReply(count > 0, tok, n);
+        if (count == 0) {
+            batchEnd("not-found");
+            return;
+        }
+        outPutChars(" ", 1);
+        outPutInt((owner->pokemonCount - 1) / pageSize + 1);
+        outPutChars(" ", 1);
+        for (int i = 0; i < count; i++) {
+            if (i > 0)
+                outPutChars(",", 1);
+            outPutInt(entries[i]->id);
+        }
+        batchEnd(NULL);
+    }
+    else if (strncmp(cmd, "range", 5) == 0) {
+        int lo, hi;
+        if (n != 4 || !parseBatchInt(tok[2], &lo) || !parseBatchInt(tok[3], &hi)) {
+            batchReply(0, tok, n);
+            batchEnd("bad-args");
+            return;
+        }
+        batchReply(1, tok, n);
+        outPutChars(" ", 1);
+        if (cmd[5] == '\0') {
+            const PokemonData *entries[POKEDEX_SIZE];
+            int count = pokedexRange(owner, lo, hi, entries);
+            outPutInt(count);
+            outPutChars(" ", 1);
+            if (count == 0)
+                outPutChars("-", 1);
+            for (int i = 0; i < count; i++) {
+                if (i > 0)
+                    outPutChars(",", 1);
+                outPutInt(entries[i]->id);
+            }
+        }
+        else {
+            //count and sums come from subtree summaries, no node is visited
+            RangeTotals t = pokedexRangeTotals(owner, lo, hi);
+            outPutInt(t.count);
+            if (cmd[5] == 's') {
+                outPutChars(" ", 1);
+                outPutInt(t.hp);
+                outPutChars(" ", 1);
+                outPutInt(t.attack);
+            }
+        }
+        batchEnd(NULL);
+    }
+    else if (strcmp(cmd, "team") == 0) {
+        //all O(1): owner totals plus the root's subtree maximum
+        const PokemonData *best = pokedexStrongest(owner);
+        batchReply(1, tok, n);
+        outPutChars(" ", 1);
+        outPutInt(owner->pokemonCount);
+        outPutChars(" ", 1);
+        outPutTenths(owner->totalAttack * 15 + owner->totalHp * 12);
+        outPutChars(" ", 1);
+        outPutInt(owner->totalHp);
+        outPutChars(" ", 1);
+        outPutInt(owner->totalAttack);
+        outPutChars(" ", 1);
+        if (best == NULL)
+            outPutChars("-", 1);
+        else
+            outPutInt(best->id);
+        batchEnd(NULL);
+    }
+    else if (strcmp(cmd, "types") == 0) {
+        batchReply(1, tok, n);
+        for (int t = 0; t < TYPE_COUNT; t++) {
+            outPutChars(" ", 1);
+            outPutInt(owner->typeCounts[t]);
+        }
+        batchEnd(NULL);
+    }
+    else if (strcmp(cmd, "bytype") == 0) {
+        int type = (n == 3) ? parseTypeName(tok[2]) : -1;
+        if (type < 0) {
+            batchReply(0, tok, n);
+            batchEnd("bad-args");
+            return;
+        }
+        const PokemonData *entries[POKEDEX_SIZE];
+        int count = pokedexOfType(owner, (PokemonType)type, entries);
+        batchReply(1, tok, n);
+        outPutChars(" ", 1);
+        outPutInt(count);
+        outPutChars(" ", 1);
+        if (count == 0)
+            outPutChars("-", 1);
+        for (int i = 0; i < count; i++) {
+            if (i > 0)
+                outPutChars(",", 1);
+            outPutInt(entries[i]->id);
+        }
+        batchEnd(NULL);
+    }
+    else if (strcmp(cmd, "dump") == 0) {
+        batchReply(1, tok, n);
+        batchDump(owner, n > 2 ? tok[2] : "in");
+        batchEnd(NULL);
+    }
+    else {
+        int toBitset = n == 3 && strcmp(tok[2], "bitset") == 0;
+        if (n != 3 || (!toBitset && strcmp(tok[2], "tree") != 0)) {
+            batchReply(0, tok, n);
+            batchEnd("bad-args");
+            return;
+        }
+        owner->storageLocked = 1;
+        setPokedexStorage(owner, toBitset ? STORAGE_BITSET : STORAGE_TREE);
+        journalRecord(JOURNAL_STORAGE, owner->ownerName, NULL, owner->storage);
+        batchReply(1, tok, n);
+        batchEnd(NULL);
+    }
+}
+
+void runBatch(void) {
+    char *tokens[BATCH_MAX_TOKENS];
+    size_t len;
+    char *line;
+    initNameRanks();
+    //group commit: scripted mutations are synced in 64K groups, not one by one
+    journal.groupBytes = JOURNAL_GROUP;
+    outBeginBatch();
+    while ((line = readLineSlice(&len)) != NULL) {
+        int n = splitTokens(line, tokens);
+        if (n == 0)
+            continue;
+        MenuAction action = batchAction(tokens[0]);
+        ActionTimer timer;
+        actionStart(&timer);
+        batchCommand(tokens, n);
+        if (action != ACTION_COUNT)
+            actionEnd(&timer, action);
+    }
+    outEndBatch();
+    journalCommit();
+    if (snapshotPath != NULL && !checkpointSnapshot(snapshotPath))
+        printf("Could not save snapshot to %s.\n", snapshotPath);
+    freeAllOwners(ownerIndex.count);
+}
+
+// --------------------------------------------------------------
+// Benchmark
+// --------------------------------------------------------------
+typedef struct {
+    const char *name;
+    uint64_t *ns;     // one sample per timed call
+    size_t count;
+    size_t capacity;
+    uint64_t total;
+} BenchStat;
+
+//xorshift64*: deterministic for a given seed on every platform
+static uint64_t benchState;
+
+static uint64_t benchRandom(void) {
+    benchState ^= benchState >> 12;
+    benchState ^= benchState << 25;
+    benchState ^= benchState >> 27;
+    return benchState * 2685821657736338717ULL;
+}
+
+static int benchRandomBelow(int n) {
+    return (int)(benchRandom() % (uint64_t)n);
+}
+
+static void benchShuffle(int *a, int n) {
+    for (int i = n - 1; i > 0; i--) {
+        int j = benchRandomBelow(i + 1);
+        int t = a[i];
+        a[i] = a[j];
+        a[j] = t;
+    }
+}
+
+static void benchRecord(BenchStat *st, uint64_t start) {
+    uint64_t ns = nowNs() - start;
+    st->total += ns;
+    if (st->count == st->capacity) {
+        size_t cap = st->capacity ? st->capacity * 2 : 1024;
+        uint64_t *grown = exRealloc(st->ns, cap * sizeof(uint64_t), MEM_DATA);
+        if (!grown)
+            return;
+        st->ns = grown;
+        st->capacity = cap;
+    }
+    st->ns[st->count++] = ns;
+}
+
+static int compareU64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static int compareInts(const void *a, const void *b) {
+    return *(const int *)a - *(const int *)b;
+}
+
+static void benchReport(BenchStat *st) {
+    if (st->count == 0)
+        return;
+    qsort(st->ns, st->count, sizeof(uint64_t), compareU64);
+    size_t last = st->count - 1;
+    double opsPerSec = st->total ? (double)st->count * 1e9 / (double)st->total : 0.0;
+    printf("%-22s %10zu %14.0f %10llu %10llu %10llu %12llu\n", st->name, st->count, opsPerSec,
+           (unsigned long long)st->ns[last / 2], (unsigned long long)st->ns[last * 9 / 10],
+           (unsigned long long)st->ns[last * 99 / 100], (unsigned long long)st->ns[last]);
+    exFree(st->ns);
+    st->ns = NULL;
+    st->count = st->capacity = 0;
+    st->total = 0;
+}
+
+static int benchVisited;
+
+static void benchCountVisit(PokemonNode *node) {
+    (void)node;
+    benchVisited++;
+}
+
+static void benchCountCtxVisit(PokemonNode *node, void *ctx) {
+    (void)node;
+    (void)ctx;
+    benchVisited++;
+}
+
+//display output goes to the null device so the terminal isn't what gets measured
+static int benchMuteStdout(void) {
+#if defined(_WIN32)
+    return -1;
+#else
+    fflush(stdout);
+    int saved = dup(STDOUT_FILENO);
+    FILE *null = fopen("/dev/null", "w");
+    if (saved < 0 || !null) {
+        if (null)
+            fclose(null);
+        if (saved >= 0)
+            close(saved);
+        return -1;
+    }
+    dup2(fileno(null), STDOUT_FILENO);
+    fclose(null);
+    return saved;
+#endif
+}
+
+static void benchRestoreStdout(int saved) {
+#if !defined(_WIN32)
+    fflush(stdout);
+    if (saved >= 0) {
+        dup2(saved, STDOUT_FILENO);
+        close(saved);
+    }
+#else
+    (void)saved;
+#endif
+}
+
+//relink the ring in a random order so every sort starts from scratch
+static void benchShuffleRing(OwnerNode **owners, int n) {
+    for (int i = n - 1; i > 0; i--) {
+        int j = benchRandomBelow(i + 1);
+        OwnerNode *t = owners[i];
+        owners[i] = owners[j];
+        owners[j] = t;
+    }
+    for (int i = 0; i < n; i++) {
+        owners[i]->next = owners[(i + 1) % n];
+        owners[(i + 1) % n]->prev = owners[i];
+    }
+    ownerHead = owners[0];
+}
+
+enum { BENCH_ASCENDING, BENCH_RANDOM, BENCH_ADVERSARIAL, BENCH_ORDERS };
+
+//ids for one owner: a random subset of the species, arranged by order
+static void benchPickIds(int *ids, int m, int order) {
+    int all[POKEDEX_SIZE];
+    for (int i = 0; i < POKEDEX_SIZE; i++)
+        all[i] = i + 1;
+    benchShuffle(all, POKEDEX_SIZE);
+    qsort(all, (size_t)m, sizeof(int), compareInts);
+    if (order == BENCH_RANDOM) {
+        memcpy(ids, all, m * sizeof(int));
+        benchShuffle(ids, m);
+    }
+    else if (order == BENCH_ADVERSARIAL) {
+        //zig-zag between both ends: every insert lands on the deep side and forces rotations
+        int lo = 0, hi = m - 1;
+        for (int i = 0; i < m; i++)
+            ids[i] = (i & 1) ? all[hi--] : all[lo++];
+    }
+    else {
+        memcpy(ids, all, m * sizeof(int));
+    }
+}
+
+static void benchOneOrder(int n, int m, int order) {
+    enum { INSERT, SEARCH, REMOVE, EVOLVE, MERGE, SORT, BFS, PRE, IN, POST,
+           MORRIS_PRE, MORRIS_IN, MORRIS_POST, SHOW_BFS, SHOW_PRE, SHOW_IN, SHOW_POST,
+           SHOW_ALPHA, STAT_COUNT };
+    static const char *names[STAT_COUNT] = {
+        "pokedexAdd", "searchPokemonBFS", "pokedexRemove", "evolvePokemonByID",
+        "mergePokedexes", "sortOwners", "BFSGeneric", "preOrderGeneric", "inOrderGeneric",
+        "postOrderGeneric", "walkTreeMorris pre", "walkTreeMorris in", "walkTreeMorris post",
+        "display BFS", "display pre-order", "display in-order", "display post-order",
+        "displayAlphabetical"
+    };
+    static const char *orderNames[BENCH_ORDERS] = { "ascending", "random", "adversarial" };
+    BenchStat stats[STAT_COUNT];
+    memset(stats, 0, sizeof(stats));
+    for (int i = 0; i < STAT_COUNT; i++)
+        stats[i].name = names[i];
+
+    OwnerNode **owners = exMalloc(n * sizeof(OwnerNode *), MEM_OWNERS);
+    int ids[POKEDEX_SIZE];
+    if (!owners) {
+        printf("Memory allocation failed.\n");
+        return;
+    }
+
+    //build: owner names in random order so the sort has real work to do
+    for (int i = 0; i < n; i++) {
+        char label[32];
+        snprintf(label, sizeof(label), "owner%08d", benchRandomBelow(100000000));
+        char *name = myStrdup(label);
+        benchPickIds(ids, m, order);
+        owners[i] = name ? createOwner(name, ids[0]) : NULL;
+        if (!owners[i]) {
+            exFree(name);
+            n = i;
+            break;
+        }
+        //through pokedexAdd, so the species index and owner totals stay consistent
+        for (int k = 1; k < m; k++) {
+            uint64_t t = nowNs();
+            int added = pokedexAdd(owners[i], ids[k]);
+            benchRecord(&stats[INSERT], t);
+            if (!added)
+                break;
+        }
+    }
+
+    for (int i = 0; i < n; i++) {
+        PokemonNode *root = owners[i]->pokedexRoot;
+        for (int k = 0; k < m; k++) {
+            int id = 1 + benchRandomBelow(POKEDEX_SIZE);
+            uint64_t t = nowNs();
+            PokemonNode *hit = searchPokemonBFS(root, id);
+            benchRecord(&stats[SEARCH], t);
+            (void)hit;
+        }
+        uint64_t t = nowNs();
+        BFSGeneric(root, benchCountVisit);
+        benchRecord(&stats[BFS], t);
+        t = nowNs();
+        preOrderGeneric(root, benchCountVisit);
+        benchRecord(&stats[PRE], t);
+        t = nowNs();
+        inOrderGeneric(root, benchCountVisit);
+        benchRecord(&stats[IN], t);
+        t = nowNs();
+        postOrderGeneric(root, benchCountVisit);
+        benchRecord(&stats[POST], t);
+        t = nowNs();
+        walkTreeMorris(root, ORDER_PRE, benchCountCtxVisit, NULL);
+        benchRecord(&stats[MORRIS_PRE], t);
+        t = nowNs();
+        walkTreeMorris(root, ORDER_IN, benchCountCtxVisit, NULL);
+        benchRecord(&stats[MORRIS_IN], t);
+        t = nowNs();
+        walkTreeMorris(root, ORDER_POST, benchCountCtxVisit, NULL);
+        benchRecord(&stats[MORRIS_POST], t);
+    }
+
+    int saved = benchMuteStdout();
+    for (int i = 0; i < n; i++) {
+        //each display is one output batch, as displayMenu runs it
+        PokemonNode *root = owners[i]->pokedexRoot;
+        uint64_t t = nowNs();
+        outBeginBatch();
+        BFSGeneric(root, printPokemonNode);
+        outEndBatch();
+        benchRecord(&stats[SHOW_BFS], t);
+        t = nowNs();
+        outBeginBatch();
+        preOrderGeneric(root, printPokemonNode);
+        outEndBatch();
+        benchRecord(&stats[SHOW_PRE], t);
+        t = nowNs();
+        outBeginBatch();
+        inOrderGeneric(root, printPokemonNode);
+        outEndBatch();
+        benchRecord(&stats[SHOW_IN], t);
+        t = nowNs();
+        outBeginBatch();
+        postOrderGeneric(root, printPokemonNode);
+        outEndBatch();
+        benchRecord(&stats[SHOW_POST], t);
+        t = nowNs();
+        outBeginBatch();
+        displayAlphabetical(root);
+        outEndBatch();
+        benchRecord(&stats[SHOW_ALPHA], t);
+    }
+    benchRestoreStdout(saved);
+
+    for (int i = 0; i < n; i++) {
+        for (int k = 0; k < m; k++) {
+            int id = 1 + benchRandomBelow(POKEDEX_SIZE);
+            uint64_t t = nowNs();
+            evolvePokemonByID(owners[i], id);
+            benchRecord(&stats[EVOLVE], t);
+        }
+    }
+
+    for (int rep = 0; rep < 5 && n > 1; rep++) {
+        benchShuffleRing(owners, n);
+        uint64_t t = nowNs();
+        sortOwnerRing();
+        benchRecord(&stats[SORT], t);
+    }
+
+    //merge neighbours pairwise (the menu's merge minus its prompts)
+    int kept = 0;
+    for (int i = 0; i + 1 < n; i += 2) {
+        uint64_t t = nowNs();
+        mergePokedexes(owners[i], owners[i + 1], NULL);
+        removeOwnerFromCircularList(owners[i + 1]);
+        benchRecord(&stats[MERGE], t);
+        owners[kept++] = owners[i];
+    }
+    if (n & 1)
+        owners[kept++] = owners[n - 1];
+
+    for (int i = 0; i < kept; i++) {
+        OwnerNode *o = owners[i];
+        PokemonNode *nodes[POKEDEX_SIZE];
+        int count = collectInOrder(o->pokedexRoot, nodes);
+        for (int k = 0; k < count; k++)
+            ids[k] = nodes[k]->data->id;
+        benchShuffle(ids, count);
+        for (int k = 0; k < count; k++) {
+            uint64_t t = nowNs();
+            pokedexRemove(o, ids[k]);
+            benchRecord(&stats[REMOVE], t);
+        }
+    }
+
+    printf("\n== %s inserts: %d owners x %d Pokemon ==\n", orderNames[order], n, m);
+    printf("%-22s %10s %14s %10s %10s %10s %12s\n", "operation", "ops", "ops/sec",
+           "p50 ns", "p90 ns", "p99 ns", "max ns");
+    for (int i = 0; i < STAT_COUNT; i++)
+        benchReport(&stats[i]);
+
+    freeAllOwners(ownerIndex.count);
+    exFree(owners);
+}
+
+void runBenchmark(int owners, int perOwner, unsigned long seed) {
+    if (owners < 1)
+        owners = 1;
+    if (perOwner < 1)
+        perOwner = 1;
+    if (perOwner > POKEDEX_SIZE)
+        perOwner = POKEDEX_SIZE;
+    //the benchmark times the tree code, so keep every owner a tree
+    storagePolicy = STORAGE_TREE;
+    fastShutdown = 0;
+    initNameRanks();
+    benchState = seed ? seed : 1;
+    printf("Benchmark seed %lu\n", seed);
+    for (int order = 0; order < BENCH_ORDERS; order++)
+        benchOneOrder(owners, perOwner, order);
+#if !defined(_WIN32)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+        printf("\nPeak RSS: %ld KB\n", (long)usage.ru_maxrss);
+#endif
+}
+
+int main(int argc, char *argv[])
+{
+    int batchMode = 0, benchMode = 0, statsAtExit = 0;
+    int benchOwners = 1000, benchPokemon = 100;
+    unsigned long benchSeed = 42;
+    initNameRanks();
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--fast-exit") == 0)
+            fastShutdown = 1;
+        else if (strcmp(argv[i], "--storage=tree") == 0)
+            storagePolicy = STORAGE_TREE;
+        else if (strcmp(argv[i], "--storage=bitset") == 0)
+            storagePolicy = STORAGE_BITSET;
+        else if (strcmp(argv[i], "--storage=auto") == 0)
+            storagePolicy = STORAGE_AUTO;
+        else if (strcmp(argv[i], "--batch") == 0)
+            batchMode = 1;
+        else if (strncmp(argv[i], "--snapshot=", 11) == 0)
+            snapshotPath = argv[i] + 11;
+        else if (strncmp(argv[i], "--journal=", 10) == 0)
+            journalPath = argv[i] + 10;
+        else if (strcmp(argv[i], "--stats") == 0)
+            statsAtExit = 1;
+        else if (strcmp(argv[i], "--bench") == 0)
+            benchMode = 1;
+        else if (strncmp(argv[i], "--bench-owners=", 15) == 0)
+            benchOwners = (int)strtol(argv[i] + 15, NULL, 10);
+        else if (strncmp(argv[i], "--bench-pokemon=", 16) == 0)
+            benchPokemon = (int)strtol(argv[i] + 16, NULL, 10);
+        else if (strncmp(argv[i], "--bench-seed=", 13) == 0)
+            benchSeed = strtoul(argv[i] + 13, NULL, 10);
+    }
+    //the benchmark builds its own owners, so it never touches the snapshot
+    if (!benchMode && snapshotPath != NULL && loadSnapshot(snapshotPath) < 0) {
+        //saving the empty state at exit would destroy whatever the file still holds
+        printf("Snapshot %s is unreadable or corrupt; starting empty and leaving it untouched.\n", snapshotPath);
+        snapshotPath = NULL;
+    }
+    //the journal holds everything since that snapshot
+    if (!benchMode && journalPath != NULL && journalOpen(journalPath) < 0)
+        printf("Journal %s could not be opened; changes won't be journaled.\n", journalPath);
+    if (benchMode)
+        runBenchmark(benchOwners, benchPokemon, benchSeed);
+    else if (batchMode)
+        runBatch();
+    else
+        mainMenu();
     //freeAllOwners();
+    if (statsAtExit)
+        printStatistics(stderr);
+    journalClose();
+    releaseInput();
+#if defined(TRACK_ALLOC)
+    //whatever is still live now was never freed
+    memoryReport(stderr, 1);
+#endif
     return 0;
 }
@@ -2,6 +2,7 @@
 #define EX6_H
 
 #include <ctype.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -23,7 +24,8 @@ typedef enum
     ROCK,
     GHOST,
     DRAGON,
-    ICE
+    ICE,
+    TYPE_COUNT
 } PokemonType;
 
 typedef enum
@@ -32,6 +34,19 @@ typedef enum
     CAN_EVOLVE
 } EvolutionStatus;
 
+// Number of species in pokedex[] (IDs are 1..POKEDEX_SIZE)
+#define POKEDEX_SIZE 151
+// 64-bit words needed for one bit per species
+#define POKEDEX_WORDS ((POKEDEX_SIZE + 63) / 64)
+
+// How an owner's Pokedex is stored
+typedef enum
+{
+    STORAGE_TREE,   // AVL tree of pool-allocated PokemonNodes
+    STORAGE_BITSET, // One bit per species ID
+    STORAGE_AUTO    // Policy only: pick per owner by density
+} StorageMode;
+
 typedef struct PokemonData
 {
     int id;
@@ -45,40 +60,202 @@ typedef struct PokemonData
 // Binary Tree Node (for Pokédex)
 typedef struct PokemonNode
 {
-    PokemonData *data;
+    const PokemonData *data;  // Points into the read-only pokedex[] catalog
     struct PokemonNode *left;
     struct PokemonNode *right;
     struct PokemonNode *parent;
+    int height;               // AVL height of the subtree rooted here (leaf = 1)
+    int size;                 // Nodes in the subtree rooted here (leaf = 1)
+    int sumHp;                // HP summed over the subtree
+    int sumAttack;            // Attack summed over the subtree
+    const PokemonData *best;  // Strongest entry in the subtree (see pokemonStronger)
 } PokemonNode;
 
+// Count and stat totals over a range of IDs
+typedef struct RangeTotals {
+    int count;
+    int hp;
+    int attack;
+} RangeTotals;
+
+// A contiguous block of slots; slabs double in size as an owner grows
+typedef struct PoolSlab
+{
+    struct PoolSlab *next; // Older slab in the same pool
+    int capacity;          // Number of slots in this slab
+    int used;              // Slots handed out by bump allocation so far
+    PokemonNode slots[];
+} PoolSlab;
+
+// Per-owner node region (all of an owner's Pokemon live in its slabs)
+typedef struct NodePool
+{
+    PoolSlab *slabs;       // Newest slab first
+    PokemonNode *freeList; // Released nodes, chained through ->left
+} NodePool;
+
 // Linked List Node (for Owners)
 typedef struct OwnerNode
 {
     char *ownerName;          // Owner's name
+    uint64_t namePrefix;      // First 8 name bytes, packed for fast sorting
     PokemonNode *pokedexRoot; // Pointer to the root of the owner's Pokédex
+    NodePool pool;            // Region that owns every node in pokedexRoot
+    StorageMode storage;      // STORAGE_TREE or STORAGE_BITSET
+    int storageLocked;        // Set once the user picks a mode; auto policy leaves it alone
+    uint64_t bits[POKEDEX_WORDS]; // Species bitset (only meaningful in STORAGE_BITSET)
+    int pokemonCount;         // Number of Pokemon owned, in either storage mode
+    int speciesSlot[POKEDEX_SIZE]; // Position in speciesIndex[id - 1].owners, -1 if not held
+    int typeCounts[TYPE_COUNT];    // Pokemon owned per type
+    int totalHp;              // HP summed over the Pokedex
+    int totalAttack;          // Attack summed over the Pokedex
     struct OwnerNode *next;   // Next owner in the linked list
     struct OwnerNode *prev;   // Previous owner in the linked list
 } OwnerNode;
 
-typedef struct QueueNode {
-    PokemonNode *data;
-    struct QueueNode *next;
-} QueueNode;
+// Slots kept inside the Queue itself; a whole Pokedex level always fits
+#define QUEUE_INLINE_CAP 128
 
+// Growable ring buffer of node pointers
 typedef struct Queue {
-    QueueNode *head;
-    QueueNode *tail;
+    PokemonNode **items;  // inlineItems until the queue outgrows it
+    int head;             // Index of the next node to dequeue
+    int count;            // Number of queued nodes
+    int capacity;         // Size of items
+    PokemonNode *inlineItems[QUEUE_INLINE_CAP];
 } Queue;
 
 // Global head pointer for the linked list of owners
 OwnerNode *ownerHead = NULL;
 
+// Open-addressing (linear probing) hash table from owner name to OwnerNode
+typedef struct OwnerIndex {
+    OwnerNode **slots; // NULL = never used; capacity is a power of two
+    int capacity;
+    int count;         // Live owners (always equals the ring's length)
+    int tombstones;    // Deleted slots still occupying probe chains
+} OwnerIndex;
+
+// Name index over every owner in the ring
+OwnerIndex ownerIndex = { NULL, 0, 0, 0 };
+
+// Owners holding one species, in no particular order
+typedef struct SpeciesHolders {
+    OwnerNode **owners;
+    int count;
+    int capacity;
+} SpeciesHolders;
+
+// Inverted index: speciesIndex[id - 1] lists every owner holding that species
+SpeciesHolders speciesIndex[POKEDEX_SIZE];
+
+// Subsystems the tracking allocator accounts memory to
+typedef enum
+{
+    MEM_OWNERS,  // OwnerNodes and the owner index
+    MEM_NODES,   // node pool slabs
+    MEM_DATA,    // I/O, snapshot, journal and benchmark buffers
+    MEM_QUEUES,  // BFS queues and traversal stacks
+    MEM_NAMES,   // owner names and input lines
+    MEM_KIND_COUNT
+} MemKind;
+
+// Build with -DTRACK_ALLOC to route every allocation through the tracking allocator;
+// otherwise these are plain malloc/calloc/realloc/free. Either way each allocation
+// bumps opStats.heapAllocs, so no call site counts by hand
+#if defined(TRACK_ALLOC)
+void *trackMalloc(size_t size, MemKind kind, int line);
+void *trackCalloc(size_t count, size_t size, MemKind kind, int line);
+void *trackRealloc(void *ptr, size_t size, MemKind kind, int line);
+void trackFree(void *ptr);
+#define exMalloc(size, kind) (opStats.heapAllocs++, trackMalloc((size), (kind), __LINE__))
+#define exCalloc(count, size, kind) (opStats.heapAllocs++, trackCalloc((count), (size), (kind), __LINE__))
+#define exRealloc(ptr, size, kind) (opStats.heapAllocs++, trackRealloc((ptr), (size), (kind), __LINE__))
+#define exFree(ptr) trackFree(ptr)
+#else
+#define exMalloc(size, kind) (opStats.heapAllocs++, malloc(size))
+#define exCalloc(count, size, kind) (opStats.heapAllocs++, calloc((count), (size)))
+#define exRealloc(ptr, size, kind) (opStats.heapAllocs++, realloc((ptr), (size)))
+#define exFree(ptr) free(ptr)
+#endif
+
+// Latency histogram buckets: bucket k counts calls taking [2^k, 2^(k+1)) ns
+#define LATENCY_BUCKETS 40
+
+typedef enum { TREE_SEARCH, TREE_INSERT, TREE_REMOVE, TREE_OP_COUNT } TreeOp;
+
+typedef enum
+{
+    ACTION_NEW,
+    ACTION_ADD,
+    ACTION_DISPLAY,
+    ACTION_RELEASE,
+    ACTION_FIGHT,
+    ACTION_EVOLVE,
+    ACTION_STORAGE,
+    ACTION_DELETE,
+    ACTION_MERGE,
+    ACTION_SORT,
+    ACTION_PRINT,
+    ACTION_SAVE,
+    ACTION_HOLDERS,
+    ACTION_BY_TYPE,
+    ACTION_TEAM,
+    ACTION_LEADERBOARD,
+    ACTION_COUNT
+} MenuAction;
+
+typedef struct TreeOpStats {
+    uint64_t calls;
+    uint64_t nodesTouched;  // tree nodes visited, summed over calls
+    int maxDepth;           // deepest single call
+} TreeOpStats;
+
+typedef struct ActionStats {
+    uint64_t calls;
+    uint64_t totalNs;       // time spent, minus time blocked on input
+    uint64_t heapAllocs;
+    uint64_t nodeAllocs;
+    uint64_t buckets[LATENCY_BUCKETS];
+} ActionStats;
+
+typedef struct OpStats {
+    TreeOpStats tree[TREE_OP_COUNT];
+    ActionStats action[ACTION_COUNT];
+    uint64_t heapAllocs;    // exMalloc/exCalloc/exRealloc calls
+    uint64_t nodeAllocs;    // PokemonNodes handed out by the pools
+    uint64_t inputWaitNs;   // time blocked reading stdin
+} OpStats;
+
+// Always-on counters; plain increments, no locking (single thread)
+OpStats opStats;
+
+// Snapshot of the counters taken when an action starts
+typedef struct ActionTimer {
+    uint64_t start;
+    uint64_t heapAllocs;
+    uint64_t nodeAllocs;
+    uint64_t inputWaitNs;
+} ActionTimer;
+
+// Storage mode given to new owners (STORAGE_AUTO switches by density)
+StorageMode storagePolicy = STORAGE_TREE;
+
+// When set, freeAllOwners skips releasing memory and lets the OS reclaim it at exit
+int fastShutdown = 0;
+
+// Snapshot loaded at startup and saved at exit (--snapshot=path), NULL for none or if it failed to load
+const char *snapshotPath = NULL;
+
+// Write-ahead journal replayed on top of the snapshot (--journal=path), NULL for none
+const char *journalPath = NULL;
+
 char* pokemonType(PokemonType type);
 char* canEvolve(EvolutionStatus evolve);
 
 
-void freeQueue();
-Queue *createQueue();
+void initQueue(Queue *q);
+void destroyQueue(Queue *q);
 void enqueue(Queue *q, PokemonNode *node);
 PokemonNode *dequeue(Queue *q);
 int isEmpty(Queue *q);
@@ -87,6 +264,13 @@ int isEmpty(Queue *q);
    1) Safe Input + Utility
    ------------------------------------------------------------ */
 
+/**
+ * @brief Monotonic clock in nanoseconds.
+ * @return current time
+ * Why we made it: Shared by the statistics and the benchmark.
+ */
+uint64_t nowNs(void);
+
 /**
  * @brief Remove leading/trailing whitespace (including '\r').
  * @param str modifiable string
@@ -102,6 +286,20 @@ void trimWhitespace(char *str);
  */
 char *myStrdup(const char *src);
 
+/**
+ * @brief Next stdin line as a slice of the shared input buffer (newline replaced by '\0').
+ * @param len receives the line length
+ * @return pointer into the buffer (valid until the next read), or NULL at EOF
+ * Why we made it: Reads stdin in 64 KiB chunks; callers parse lines without copying.
+ */
+char *readLineSlice(size_t *len);
+
+/**
+ * @brief Free the shared input buffer.
+ * Why we made it: Clean exit.
+ */
+void releaseInput(void);
+
 /**
  * @brief Read an integer safely, re-prompt if invalid.
  * @param prompt text to display
@@ -111,7 +309,7 @@ char *myStrdup(const char *src);
 int readIntSafe(const char *prompt);
 
 /**
- * @brief Read a line from stdin, store in malloc'd buffer, trim whitespace.
+ * @brief Read a line from stdin, trim whitespace, return it in an exact-size malloc'd copy.
  * @return pointer to the newly allocated string (caller frees)
  * Why we made it: We need flexible name input that handles CR/LF etc.
  */
@@ -125,43 +323,87 @@ char *getDynamicInput(void);
  */
 const char *getTypeName(PokemonType type);
 
+/**
+ * @brief Parse a type name ("fire", "FIRE", ...).
+ * @param name the text
+ * @return the PokemonType, or -1 if it isn't one
+ * Why we made it: Type queries take the type by name.
+ */
+int parseTypeName(const char *name);
+
+/**
+ * @brief The catalog IDs of one type, ascending.
+ * @param type the type
+ * @param count set to how many there are
+ * @return pointer into a table built on first use
+ * Why we made it: Type queries look at this type's species and nothing else.
+ */
+const int *typeSpecies(PokemonType type, int *count);
+
 /* ------------------------------------------------------------
    2) Creating & Freeing Nodes
    ------------------------------------------------------------ */
 
 /**
- * @brief Create a BST node with a copy of the given PokemonData.
- * @param data pointer to PokemonData (like from the global pokedex)
+ * @brief Hand out one node from an owner's pool.
+ * @param pool the owner's NodePool
+ * @return uninitialized node, or NULL on failure
+ * Why we made it: One bump/free-list pop instead of two mallocs per Pokemon.
+ */
+PokemonNode *poolAllocNode(NodePool *pool);
+
+/**
+ * @brief Return a single node to its pool's free list.
+ * @param pool the owner's NodePool
+ * @param node node previously handed out by poolAllocNode(pool)
+ * Why we made it: Released Pokemon are recycled by the next add/evolve.
+ */
+void poolFreeNode(NodePool *pool, PokemonNode *node);
+
+/**
+ * @brief Free every slab of a pool at once, invalidating all its nodes.
+ * @param pool the owner's NodePool
+ * Why we made it: Dropping a whole Pokedex is one pass over a few slabs, not a tree walk.
+ */
+void poolRelease(NodePool *pool);
+
+/**
+ * @brief Move all slabs (and free slots) of src into dst, leaving src empty.
+ * @param dst pool that takes ownership
+ * @param src pool being emptied
+ * Why we made it: Merging owners keeps nodes alive after the second owner is freed.
+ */
+void poolAdopt(NodePool *dst, NodePool *src);
+
+/**
+ * @brief Create a BST node referencing a species in the global pokedex.
+ * @param pool the owner's NodePool to allocate from
+ * @param data pointer into pokedex[] (species data is shared, never copied)
  * @return newly allocated PokemonNode*
  * Why we made it: We need a standard way to allocate BST nodes.
  */
-PokemonNode *createPokemonNode(const PokemonData *data);
+PokemonNode *createPokemonNode(NodePool *pool, const PokemonData *data);
 
 /**
- * @brief Create an OwnerNode for the circular owners list.
- * @param ownerName the dynamically allocated name
- * @param starter BST root for the starter Pokemon
- * @return newly allocated OwnerNode*
+ * @brief Create an OwnerNode holding one starter and link it into the ring.
+ * @param ownerName the dynamically allocated name (owned by the node afterwards)
+ * @param starterId ID of the starter Pokemon (0: start empty)
+ * @return newly allocated OwnerNode*, or NULL if the starter is invalid or allocation
+ *         fails (the name then still belongs to the caller)
  * Why we made it: Each user is represented as an OwnerNode.
  */
-OwnerNode *createOwner(char *ownerName, PokemonNode *starter);
+OwnerNode *createOwner(char *ownerName, int starterId);
 
 /**
- * @brief Free one PokemonNode (including name).
+ * @brief Return one PokemonNode to its pool.
+ * @param pool the pool the node came from
  * @param node pointer to node
  * Why we made it: Avoid memory leaks for single nodes.
  */
-void freePokemonNode(PokemonNode *node);
+void freePokemonNode(NodePool *pool, PokemonNode *node);
 
 /**
- * @brief Recursively free a BST of PokemonNodes.
- * @param root BST root
- * Why we made it: Clearing a user’s entire Pokedex means freeing a tree.
- */
-void freePokemonTree(PokemonNode *root);
-
-/**
- * @brief Free an OwnerNode (including name and entire Pokedex BST).
+ * @brief Free an OwnerNode (including name and its whole node pool).
  * @param owner pointer to the owner
  * Why we made it: Deleting an owner also frees their Pokedex & name.
  */
@@ -172,40 +414,291 @@ void freeOwnerNode(OwnerNode *owner);
    ------------------------------------------------------------ */
 
 /**
- * @brief Insert a PokemonNode into BST by ID; duplicates freed.
- * @param root pointer to BST root
+ * @brief Height of an AVL subtree (0 for NULL).
+ * @param node subtree root
+ * @return stored height
+ * Why we made it: Lets the balance code treat empty subtrees uniformly.
+ */
+int nodeHeight(PokemonNode *node);
+
+/**
+ * @brief Rotate a subtree left/right around its root, fixing parents and heights.
+ * @param root subtree root
+ * @return new subtree root
+ * Why we made it: Building blocks of AVL rebalancing.
+ */
+PokemonNode *rotateLeft(PokemonNode *root);
+PokemonNode *rotateRight(PokemonNode *root);
+
+/**
+ * @brief Restore the AVL invariant at one node after an insert/remove below it.
+ * @param root subtree root whose children are already balanced
+ * @return new subtree root
+ * Why we made it: Keeps the Pokedex O(log n) tall regardless of insert order.
+ */
+PokemonNode *rebalance(PokemonNode *root);
+
+/**
+ * @brief Insert a PokemonNode into the AVL tree by ID; duplicates freed.
+ * @param pool pool newNode came from (a rejected duplicate goes back there)
+ * @param root pointer to BST root (may be NULL)
  * @param newNode node to insert
  * @return updated BST root
- * Why we made it: Standard BST insertion ignoring duplicates.
+ * Why we made it: Balanced insertion so ascending IDs don't build a linked list.
  */
-PokemonNode *insertPokemonNode(PokemonNode *root, PokemonNode *newNode);
+PokemonNode *insertPokemonNode(NodePool *pool, PokemonNode *root, PokemonNode *newNode);
 
 /**
- * @brief BFS search for a Pokemon by ID in the BST.
+ * @brief Find a Pokemon by ID with one root-to-leaf descent (the name predates the AVL tree).
  * @param root BST root
  * @param id ID to find
  * @return pointer to found node or NULL
- * Why we made it: BFS ensures we find nodes even in an unbalanced tree.
+ * Why we made it: The tree is kept balanced, so a plain descent is O(log n).
  */
 PokemonNode *searchPokemonBFS(PokemonNode *root, int id);
 
 /**
- * @brief Remove node from BST by ID if found (BST removal logic).
+ * @brief Find a node by ID together with its in-order successor.
+ * @param root BST root
+ * @param id ID to find
+ * @param successor set to the node with the next larger ID (NULL if none, or if id is absent)
+ * @return pointer to found node or NULL
+ * Why we made it: Evolve learns whether id+1 is owned from the same descent.
+ */
+PokemonNode *searchWithSuccessor(PokemonNode *root, int id, PokemonNode **successor);
+
+/**
+ * @brief Point a node at another species and refresh the summaries above it.
+ * The caller guarantees the new ID keeps the tree in order.
+ * @param node node to change
+ * @param data new pokedex entry
+ * Why we made it: Evolving id -> id+1 (when id+1 isn't owned) is an in-place key update.
+ */
+void relabelPokemonNode(PokemonNode *node, const PokemonData *data);
+
+/**
+ * @brief Remove node from the AVL tree by ID if found, rebalancing on the way up.
+ * @param pool pool the removed node is returned to
  * @param root BST root
  * @param id ID to remove
  * @return updated BST root
  * Why we made it: We handle special cases of a BST remove (0,1,2 children).
  */
-PokemonNode *removeNodeBST(PokemonNode *root, int id);
+PokemonNode *removeNodeBST(NodePool *pool, PokemonNode *root, int id);
 
 /**
- * @brief Combine BFS search + BST removal to remove Pokemon by ID.
- * @param root BST root
+ * @brief Combine search + removal to remove Pokemon by ID, printing the outcome.
+ * @param owner pointer to the Owner
  * @param id the ID to remove
- * @return updated BST root
- * Why we made it: BFS confirms existence, then removeNodeBST does the removal.
+ * @return 1 if it was removed
+ * Why we made it: Search confirms existence, then pokedexRemove does the removal.
+ */
+int removePokemonByID(OwnerNode *owner, int id);
+
+/**
+ * @brief Subtree size of a node (0 for NULL).
+ * @param node pointer to node
+ * @return node->size or 0
+ * Why we made it: Every rotation and rebalance keeps sizes next to heights.
+ */
+int nodeSize(PokemonNode *node);
+
+/**
+ * @brief k-th smallest ID in a tree, by subtree sizes.
+ * @param root BST root
+ * @param k 1-based position
+ * @return the node, or NULL if k is out of range
+ * Why we made it: O(log n) instead of walking k nodes.
+ */
+PokemonNode *kthPokemonNode(PokemonNode *root, int k);
+
+/**
+ * @brief How many IDs in the tree are smaller than id.
+ * @param root BST root
+ * @param id the ID
+ * @return count of smaller IDs (id itself need not be present)
+ * Why we made it: O(log n) rank queries.
+ */
+int pokemonRank(PokemonNode *root, int id);
+
+/**
+ * @brief Smallest node whose ID is >= id.
+ * @param root BST root
+ * @param id lower bound
+ * @return that node, or NULL if every ID is smaller
+ * Why we made it: Where a range walk starts.
+ */
+PokemonNode *lowerBoundNode(PokemonNode *root, int id);
+
+/**
+ * @brief Count, HP and attack totals of the IDs in [lo, hi].
+ * @param root BST root
+ * @param lo first ID
+ * @param hi last ID
+ * @return the totals
+ * Why we made it: Two O(log n) descents over subtree summaries, visiting no range nodes.
+ */
+RangeTotals rangeTotals(PokemonNode *root, int lo, int hi);
+
+/**
+ * @brief Link already-allocated nodes, sorted by ID, into a perfectly balanced tree.
+ * @param nodes array of nodes in ascending ID order
+ * @param n number of nodes
+ * @return root of the new tree (parents and heights set), NULL if n == 0
+ * Why we made it: O(n) rebuilds from sorted IDs (bitset views, conversions).
  */
-PokemonNode *removePokemonByID(PokemonNode *root, int id);
+PokemonNode *buildBalancedTree(PokemonNode **nodes, int n);
+
+/* ------------------------------------------------------------
+   3b) Owner Pokedex Storage (AVL tree or species bitset)
+   ------------------------------------------------------------ */
+
+/**
+ * @brief Look up a species in an owner's Pokedex, whatever its storage mode.
+ * @param owner pointer to the Owner
+ * @param id species ID (out-of-range IDs are simply not found)
+ * @return pointer into pokedex[] or NULL if not owned
+ * Why we made it: One membership test for tree and bitset owners.
+ */
+const PokemonData *pokedexFind(OwnerNode *owner, int id);
+
+/**
+ * @brief Add a species to an owner's Pokedex (no messages printed).
+ * @param owner pointer to the Owner
+ * @param id species ID, 1..POKEDEX_SIZE
+ * @return 1 if added, 0 if already present, invalid or out of memory
+ * Why we made it: Single mutation entry point for both storage modes.
+ */
+int pokedexAdd(OwnerNode *owner, int id);
+
+/**
+ * @brief Remove a species from an owner's Pokedex (no messages printed).
+ * @param owner pointer to the Owner
+ * @param id species ID
+ * @return 1 if removed, 0 if it was not there
+ * Why we made it: Single mutation entry point for both storage modes.
+ */
+int pokedexRemove(OwnerNode *owner, int id);
+
+/**
+ * @brief Get a tree to traverse for display/merge, materializing bitsets on the stack.
+ * @param owner pointer to the Owner
+ * @param scratch caller-provided room for POKEDEX_SIZE nodes (used in bitset mode)
+ * @return tree root (owner's own tree, or a balanced tree built in scratch)
+ * Why we made it: Every traversal keeps working unchanged for bitset owners.
+ */
+PokemonNode *pokedexView(OwnerNode *owner, PokemonNode *scratch);
+
+/**
+ * @brief Convert an owner's Pokedex to the given storage mode.
+ * @param owner pointer to the Owner
+ * @param mode STORAGE_TREE or STORAGE_BITSET
+ * Why we made it: Dense owners are cheaper and faster as a 151-bit set.
+ */
+void setPokedexStorage(OwnerNode *owner, StorageMode mode);
+
+/**
+ * @brief k-th smallest ID an owner has, whatever the storage.
+ * @param owner pointer to the Owner
+ * @param k 1-based position
+ * @return the entry, or NULL if k is out of range
+ * Why we made it: Order statistics on trees (sizes) and bitsets (popcounts).
+ */
+const PokemonData *pokedexKth(OwnerNode *owner, int k);
+
+/**
+ * @brief 1-based position of id among an owner's IDs.
+ * @param owner pointer to the Owner
+ * @param id the ID
+ * @return its rank, or 0 if the owner doesn't have it
+ * Why we made it: Companion to pokedexKth.
+ */
+int pokedexRank(OwnerNode *owner, int id);
+
+/**
+ * @brief One page of an owner's Pokemon in ID order.
+ * @param owner pointer to the Owner
+ * @param page 1-based page number
+ * @param pageSize entries per page
+ * @param out receives up to pageSize entries
+ * @return entries written (0 if the page doesn't exist)
+ * Why we made it: O(log n + pageSize) instead of walking the whole tree.
+ */
+int pokedexPage(OwnerNode *owner, int page, int pageSize, const PokemonData **out);
+
+/**
+ * @brief An owner's Pokemon with IDs in [lo, hi], ascending.
+ * @param owner pointer to the Owner
+ * @param lo first ID
+ * @param hi last ID
+ * @param out receives the entries (POKEDEX_SIZE slots)
+ * @return entries written
+ * Why we made it: O(log n + k) instead of a full in-order dump.
+ */
+int pokedexRange(OwnerNode *owner, int lo, int hi, const PokemonData **out);
+
+/**
+ * @brief Count-only / aggregate-only form of pokedexRange.
+ * @param owner pointer to the Owner
+ * @param lo first ID
+ * @param hi last ID
+ * @return count, HP and attack totals in the range
+ * Why we made it: Trees answer from subtree summaries, bitsets from masked words.
+ */
+RangeTotals pokedexRangeTotals(OwnerNode *owner, int lo, int hi);
+
+/**
+ * @brief An owner's Pokemon of one type, ascending by ID (owner->typeCounts has the count).
+ * @param owner pointer to the Owner
+ * @param type the type
+ * @param out receives the entries (POKEDEX_SIZE slots)
+ * @return entries written
+ * Why we made it: Probes only that type's species through the species index,
+ *                 instead of walking the tree and comparing every TYPE.
+ */
+int pokedexOfType(OwnerNode *owner, PokemonType type, const PokemonData **out);
+
+/**
+ * @brief An owner's strongest Pokemon (see pokemonStronger).
+ * @param owner pointer to the Owner
+ * @return the entry, or NULL if the Pokedex is empty
+ * Why we made it: O(1) from the root's subtree maximum; bitsets check species
+ *                 strongest-first.
+ */
+const PokemonData *pokedexStrongest(OwnerNode *owner);
+
+/**
+ * @brief Catalog indexes (ID - 1) ordered strongest-first by pokemonStronger.
+ * @return POKEDEX_SIZE entries, built on first use
+ * Why we made it: Strongest-first scans for bitset owners and the leaderboard.
+ */
+const int *speciesByScore(void);
+
+/**
+ * @brief Sum of pokemonScore over an owner's Pokemon.
+ * @param owner pointer to the Owner
+ * @return the team score
+ * Why we made it: The score is linear, so it comes straight from the owner's totals.
+ */
+double pokedexTeamScore(OwnerNode *owner);
+
+/**
+ * @brief Move every Pokemon of second into first, dropping duplicates.
+ * @param first owner that receives the Pokemon
+ * @param second owner left empty (but still in the ring) afterwards
+ * @param droppedIds optional array (POKEDEX_SIZE entries) filled with the dropped IDs, ascending
+ * @return number of duplicate IDs dropped
+ * Why we made it: Sorted merge of both in-order sequences that relinks second's
+ *                 nodes and rebuilds a balanced tree in O(n+m), with no allocations.
+ */
+int mergePokedexes(OwnerNode *first, OwnerNode *second, int *droppedIds);
+
+/**
+ * @brief Apply storagePolicy to an owner after its size changed.
+ * @param owner pointer to the Owner
+ * Why we made it: STORAGE_AUTO flips owners between modes by density.
+ */
+void applyStoragePolicy(OwnerNode *owner);
 
 /* ------------------------------------------------------------
    4) Generic BST Traversals (Function Pointers)
@@ -216,6 +709,47 @@ PokemonNode *removePokemonByID(PokemonNode *root, int id);
 
 typedef void (*VisitNodeFunc)(PokemonNode *);
 
+// Visitor that also receives caller state (used by the traversal engine)
+typedef void (*VisitNodeCtxFunc)(PokemonNode *node, void *ctx);
+
+typedef enum
+{
+    ORDER_PRE,  // Root-Left-Right
+    ORDER_IN,   // Left-Root-Right
+    ORDER_POST  // Left-Right-Root
+} TraversalOrder;
+
+// Slots kept inside the NodeStack itself; an AVL Pokedex never gets close
+#define STACK_INLINE_CAP 64
+
+// Growable explicit stack for iterative depth-first walks
+typedef struct NodeStack {
+    PokemonNode **items;  // inlineItems until the stack outgrows it
+    int count;
+    int capacity;
+    PokemonNode *inlineItems[STACK_INLINE_CAP];
+} NodeStack;
+
+/**
+ * @brief Depth-first walk with an explicit stack (no recursion).
+ * @param root BST root
+ * @param order pre-, in- or post-order
+ * @param visit called once per node; in post-order it may free the node
+ * @param ctx passed through to visit
+ * Why we made it: Recursion depth no longer follows tree height.
+ */
+void walkTreeStack(PokemonNode *root, TraversalOrder order, VisitNodeCtxFunc visit, void *ctx);
+
+/**
+ * @brief Morris (threaded) walk in O(1) extra space, same visit order as walkTreeStack.
+ * @param root BST root
+ * @param order pre-, in- or post-order
+ * @param visit called once per node; must not change or free any links
+ * @param ctx passed through to visit
+ * Why we made it: Read-only walks that need no stack at all.
+ */
+void walkTreeMorris(PokemonNode *root, TraversalOrder order, VisitNodeCtxFunc visit, void *ctx);
+
 /**
  * @brief Generic BFS traversal: call visit() on each node (level-order).
  * @param root BST root
@@ -249,46 +783,43 @@ void inOrderGeneric(PokemonNode *root, VisitNodeFunc visit);
 void postOrderGeneric(PokemonNode *root, VisitNodeFunc visit);
 
 /**
- * @brief Print one PokemonNode’s data: ID, Name, Type, HP, Attack, Evolve?
- * @param node pointer to the node
- * Why we made it: We can pass this to BFSGeneric or others to quickly print.
+ * @brief Start (or nest) a buffered output batch; flushes pending stdio output first.
+ * Why we made it: Display paths stage their text and write it with one syscall.
+ * No printf may run until the matching outEndBatch.
  */
-void printPokemonNode(PokemonNode *node);
-
-/* ------------------------------------------------------------
-   5) Display Methods (BFS, Pre, In, Post, Alphabetical)
-   ------------------------------------------------------------ */
+void outBeginBatch(void);
 
-typedef struct
-{
-    PokemonNode **nodes;
-    int size;
-    int capacity;
-} NodeArray;
+/**
+ * @brief End a batch; the outermost end writes the buffer out.
+ * Why we made it: Pairs with outBeginBatch.
+ */
+void outEndBatch(void);
 
 /**
- * @brief Initialize a NodeArray with given capacity.
- * @param na pointer to NodeArray
- * @param cap initial capacity
- * Why we made it: We store pointers to PokemonNodes for alphabetical sorting.
+ * @brief Append raw bytes / a C string / a decimal int / tenths as "12.3" to the output buffer.
+ * Why we made it: Hand-rolled formatting, no format-string parsing per field.
  */
-void initNodeArray(NodeArray *na, int cap);
+void outPutChars(const char *s, size_t n);
+void outPutStr(const char *s);
+void outPutInt(int value);
+void outPutTenths(int tenths);
 
 /**
- * @brief Add a PokemonNode pointer to NodeArray, realloc if needed.
- * @param na pointer to NodeArray
- * @param node pointer to the node
- * Why we made it: We want a dynamic list of BST nodes for sorting.
+ * @brief Write everything staged in the output buffer to stdout's fd.
+ * Why we made it: Used when a batch ends or the buffer fills up.
  */
-void addNode(NodeArray *na, PokemonNode *node);
+void outFlush(void);
 
 /**
- * @brief Recursively collect all nodes from the BST into a NodeArray.
- * @param root BST root
- * @param na pointer to NodeArray
- * Why we made it: We gather everything for qsort.
+ * @brief Print one PokemonNode’s data: ID, Name, Type, HP, Attack, Evolve? (buffered)
+ * @param node pointer to the node
+ * Why we made it: We can pass this to BFSGeneric or others to quickly print.
  */
-void collectAll(PokemonNode *root, NodeArray *na);
+void printPokemonNode(PokemonNode *node);
+
+/* ------------------------------------------------------------
+   5) Display Methods (BFS, Pre, In, Post, Alphabetical)
+   ------------------------------------------------------------ */
 
 /**
  * @brief Compare function for qsort (alphabetical by node->data->name).
@@ -300,9 +831,15 @@ void collectAll(PokemonNode *root, NodeArray *na);
 int compareByNameNode(const void *a, const void *b);
 
 /**
- * @brief BFS is nice, but alphabetical means we gather all nodes, sort by name, then print.
+ * @brief Compute every species' alphabetical rank once (idempotent).
+ * Why we made it: Names never change, so alphabetical order can be precomputed.
+ */
+void initNameRanks(void);
+
+/**
+ * @brief Alphabetical display: drop each node into its name-rank bucket, then scan.
  * @param root BST root
- * Why we made it: Provide user the option to see Pokemon sorted by name.
+ * Why we made it: Provide user the option to see Pokemon sorted by name, in O(n).
  */
 void displayAlphabetical(PokemonNode *root);
 
@@ -338,6 +875,30 @@ void postOrderTraversal(PokemonNode *root);
    6) Pokemon-Specific
    ------------------------------------------------------------ */
 
+/**
+ * @brief Battle score of a Pokemon (1.5 * attack + 1.2 * hp).
+ * @param p pokedex entry
+ * @return the score
+ * Why we made it: One formula shared by the menu and batch mode.
+ */
+double pokemonScore(const PokemonData *p);
+
+/**
+ * @brief Whether a ranks above b: higher pokemonScore, ties to the lower ID.
+ * @param a pokedex entry
+ * @param b pokedex entry
+ * @return 1 if a is stronger
+ * Why we made it: One total order for subtree maxima, "strongest" and leaderboards.
+ */
+int pokemonStronger(const PokemonData *a, const PokemonData *b);
+
+/**
+ * @brief Print an owner's team score, HP/Attack totals and strongest Pokemon.
+ * @param owner pointer to the Owner
+ * Why we made it: All of it is kept up to date, so nothing is traversed.
+ */
+void teamSummary(OwnerNode *owner);
+
 /**
  * @brief Let user pick two Pokemon by ID in the same Pokedex to fight.
  * @param owner pointer to the Owner
@@ -348,12 +909,32 @@ void pokemonFight(OwnerNode *owner);
 /**
  * @brief Evolve a Pokemon (ID -> ID+1) if allowed.
  * @param owner pointer to the Owner
- * Why we made it: Demonstrates removing an old ID, inserting the next ID.
+ * Why we made it: Menu front end for evolvePokemonByID, which finds the node and its
+ *                 successor in one descent and relabels it in place (no remove/insert).
  */
 void evolvePokemon(OwnerNode *owner);
 
+typedef enum
+{
+    EVOLVE_DONE,      //id replaced by id+1
+    EVOLVE_RELEASED,  //id+1 already owned, id released
+    EVOLVE_NOT_FOUND,
+    EVOLVE_CANNOT,
+    EVOLVE_NO_MEMORY  //the species index could not grow; nothing changed
+} EvolveResult;
+
 /**
- * @brief Prompt for an ID, BFS-check duplicates, then insert into BST.
+ * @brief Evolve one Pokemon without any I/O.
+ * @param owner pointer to the Owner
+ * @param id ID to evolve
+ * @return what happened
+ * Why we made it: Shared by the interactive menu and batch mode. One descent,
+ *                 then the node is relabelled in place (no remove, no allocation).
+ */
+EvolveResult evolvePokemonByID(OwnerNode *owner, int id);
+
+/**
+ * @brief Prompt for an ID, reject duplicates with pokedexFind, then add it through pokedexAdd.
  * @param owner pointer to the Owner
  * Why we made it: Primary user function for adding new Pokemon to an owner’s Pokedex.
  */
@@ -377,50 +958,182 @@ void freePokemon(OwnerNode *owner);
  */
 void displayMenu(OwnerNode *owner);
 
+/**
+ * @brief Prompt for a page size and number, then print that in-order page.
+ * @param owner pointer to Owner
+ * Why we made it: Large Pokedexes can be browsed without printing all of them.
+ */
+void displayPage(OwnerNode *owner);
+
+/**
+ * @brief Prompt for an ID range, print the Pokemon in it and their totals.
+ * @param owner pointer to Owner
+ * Why we made it: "Show IDs 40 to 80" without dumping the whole tree.
+ */
+void displayRange(OwnerNode *owner);
+
+/**
+ * @brief Prompt for a type and print the owner's Pokemon of that type.
+ * @param owner pointer to Owner
+ * Why we made it: "All FIRE Pokemon of this owner" without a full traversal.
+ */
+void displayByType(OwnerNode *owner);
+
 /* ------------------------------------------------------------
-   8) Sorting Owners (Bubble Sort on Circular List)
+   8) Sorting Owners (Merge Sort on Circular List)
    ------------------------------------------------------------ */
 
 /**
- * @brief Sort the circular owners list by name.
- * Why we made it: Another demonstration of pointer manipulation + sorting logic.
+ * @brief Pack the first 8 bytes of a name so integer comparison matches strcmp.
+ * @param name owner name
+ * @return big-endian, zero-padded prefix
+ * Why we made it: Most sort comparisons finish without touching ownerName.
+ */
+uint64_t computeNamePrefix(const char *name);
+
+/**
+ * @brief Stable bottom-up merge sort of the circular owners list by name.
+ * Relinks next/prev directly; owners keep their payload.
+ * Why we made it: O(n log n) comparisons instead of a bubble sort.
  */
 void sortOwners(int n);
 
 /**
- * @brief Helper to swap name & pokedexRoot in two OwnerNode.
- * @param a pointer to first owner
- * @param b pointer to second owner
- * Why we made it: Used internally by bubble sort to swap data.
+ * @brief Sort the ring without printing anything.
+ * Why we made it: The core of sortOwners, reused by batch mode.
  */
-void swapOwnerData(OwnerNode *a, OwnerNode *b);
+void sortOwnerRing(void);
 
 /* ------------------------------------------------------------
    9) Circular List Linking & Searching
    ------------------------------------------------------------ */
 
 /**
- * @brief Insert a new owner into the circular list. If none exist, it's alone.
+ * @brief Add an owner to the name index.
+ * @param owner owner whose ownerName is the key
+ * @return 1 on success, 0 if the table could not grow
+ * Why we made it: Every owner in the ring must be findable by name.
+ */
+int ownerIndexInsert(OwnerNode *owner);
+
+/**
+ * @brief Remove an owner (by identity) from the name index.
+ * @param owner owner to drop
+ * Why we made it: Deleted/merged owners must disappear from lookups.
+ */
+void ownerIndexRemove(OwnerNode *owner);
+
+/**
+ * @brief Free the name index table.
+ * Why we made it: Part of the squeaky-clean exit.
+ */
+void ownerIndexClear(void);
+
+/**
+ * @brief Insert a new owner at the tail of the circular list (and the name index).
+ * If none exist, it's alone.
  * @param newOwner pointer to newly created OwnerNode
+ * @return 1 on success, 0 if the name index could not grow (the owner is then not linked)
  * Why we made it: We need a standard approach to keep the list circular.
  */
-void linkOwnerInCircularList(OwnerNode *newOwner);
+int linkOwnerInCircularList(OwnerNode *newOwner);
 
 /**
- * @brief Remove a specific OwnerNode from the circular list, possibly updating head.
+ * @brief Remove a specific OwnerNode from the circular list and name index, then free it.
  * @param target pointer to the OwnerNode
  * Why we made it: Deleting or merging owners requires removing them from the ring.
  */
 void removeOwnerFromCircularList(OwnerNode *target);
 
 /**
- * @brief Find an owner by name in the circular list.
+ * @brief Find an owner by name through the hash index.
  * @param name string to match
  * @return pointer to the matching OwnerNode or NULL
- * Why we made it: We often need to locate an owner quickly.
+ * Why we made it: We often need to locate an owner quickly (O(1), no ring walk).
  */
 OwnerNode *findOwnerByName(const char *name);
 
+/**
+ * @brief Record that an owner holds a species (no-op if already recorded).
+ * @param owner the holder
+ * @param id species ID
+ * @return 1 on success, 0 if the holder list could not grow (nothing recorded)
+ * Why we made it: pokedexAdd keeps the species index current.
+ */
+int speciesIndexAdd(OwnerNode *owner, int id);
+
+/**
+ * @brief Forget that an owner holds a species, in O(1) (last holder fills the gap).
+ * @param owner the former holder
+ * @param id species ID
+ * Why we made it: pokedexRemove keeps the species index current.
+ */
+void speciesIndexRemove(OwnerNode *owner, int id);
+
+/**
+ * @brief Remove an owner from every species it holds.
+ * @param owner owner about to be freed
+ * Why we made it: Deleted/merged owners must not linger as holders.
+ */
+void speciesIndexDropOwner(OwnerNode *owner);
+
+/**
+ * @brief Free every holder list.
+ * Why we made it: Part of the squeaky-clean exit.
+ */
+void speciesIndexClear(void);
+
+/**
+ * @brief How many owners hold a species, in O(1).
+ * @param id species ID
+ * @return number of holders (0 for an invalid ID)
+ * Why we made it: "How rare is species X?" without searching every owner.
+ */
+int speciesHolderCount(int id);
+
+/**
+ * @brief The owners holding a species, in O(1) (walking them is O(k)).
+ * @param id species ID
+ * @param count set to the number of holders
+ * @return the holders (NULL when there are none)
+ * Why we made it: "Which trainers own Pikachu?" without searching every owner.
+ */
+OwnerNode *const *speciesHolders(int id, int *count);
+
+// Called once per (owner, Pokemon) pair found by forEachOfType / forEachTopPokemon
+typedef void (*HolderVisit)(OwnerNode *owner, const PokemonData *p, void *ctx);
+
+/**
+ * @brief How many (owner, Pokemon) pairs of a type exist, summed over its species.
+ * @param type the type
+ * @return the number of pairs
+ * Why we made it: Sizing a type query before running it.
+ */
+int typeHolderCount(PokemonType type);
+
+/**
+ * @brief Visit every (owner, Pokemon) pair of a type, by species ID.
+ * @param type the type
+ * @param visit called once per pair
+ * @param ctx passed through to visit
+ * @return number of pairs visited
+ * Why we made it: Cross-owner type queries in O(species of the type + pairs),
+ *                 never touching unrelated owners or nodes.
+ */
+int forEachOfType(PokemonType type, HolderVisit visit, void *ctx);
+
+/**
+ * @brief Visit the k strongest (owner, Pokemon) pairs across all owners, strongest first
+ * (pokemonStronger order; holders of the same species in no particular order).
+ * @param k how many
+ * @param visit called once per pair
+ * @param ctx passed through to visit
+ * @return number of pairs visited (fewer than k if there aren't that many)
+ * Why we made it: The leaderboard. Reads the species index, which every mutation
+ *                 already keeps current, in O(k + POKEDEX_SIZE) with no tree walks.
+ */
+int forEachTopPokemon(int k, HolderVisit visit, void *ctx);
+
 /* ------------------------------------------------------------
    10) Owner Menus
    ------------------------------------------------------------ */
@@ -445,7 +1158,7 @@ void deletePokedex(int n);
 
 /**
  * @brief Merge the second owner's Pokedex into the first, then remove the second owner.
- * Why we made it: BFS copy demonstration plus removing an owner.
+ * Why we made it: Linear merge (mergePokedexes) plus removing an owner.
  */
 void mergePokedexMenu(int n);
 
@@ -459,12 +1172,31 @@ void mergePokedexMenu(int n);
  */
 void printOwnersCircular(void);
 
+/**
+ * @brief Ask for a species ID and list every owner holding it.
+ * Why we made it: Answered from speciesIndex in O(k), no per-owner searches.
+ */
+void showSpeciesHolders(void);
+
+/**
+ * @brief Ask for a type and list every (owner, Pokemon) pair of it.
+ * Why we made it: Cross-owner type lookups straight from the species index.
+ */
+void showTypeHolders(void);
+
+/**
+ * @brief Ask for k and print the k strongest Pokemon across all owners.
+ * Why we made it: The global leaderboard, answered from the species index.
+ */
+void showLeaderboard(void);
+
 /* ------------------------------------------------------------
    12) Cleanup All Owners at Program End
    ------------------------------------------------------------ */
 
 /**
  * @brief Frees every remaining owner in the circular list, setting ownerHead = NULL.
+ * With fastShutdown set, nothing is freed (the process is about to exit anyway).
  * Why we made it: Ensures a squeaky-clean exit with no leftover memory.
  */
 void freeAllOwners(int n);
@@ -479,6 +1211,162 @@ void freeAllOwners(int n);
  */
 void mainMenu(void);
 
+/* ------------------------------------------------------------
+   14) Batch Mode
+   ------------------------------------------------------------ */
+
+/**
+ * @brief Run one-line commands from stdin ("add <owner> <id>", "evolve", "merge",
+ * "fight", "sort", "dump", ...) with no prompts, one "ok ..."/"err ..." reply line each.
+ * Why we made it: Scripted workloads skip the menu round trips and printf per prompt.
+ */
+void runBatch(void);
+
+/* ------------------------------------------------------------
+   15) Benchmark
+   ------------------------------------------------------------ */
+
+/**
+ * @brief Time every core operation on a seeded synthetic workload and print
+ * ops/sec, p50/p90/p99/max ns per op and peak RSS.
+ * @param owners number of owners to build
+ * @param perOwner Pokemon per owner (at most POKEDEX_SIZE)
+ * @param seed PRNG seed; the same seed gives the same workload
+ * Why we made it: Regressions in the hot paths show up as numbers.
+ * Runs ascending, random and adversarial (zig-zag) insert orders in turn.
+ */
+void runBenchmark(int owners, int perOwner, unsigned long seed);
+
+/* ------------------------------------------------------------
+   16) Snapshots
+   ------------------------------------------------------------ */
+
+/**
+ * @brief Write every owner to a versioned binary snapshot (names in one string
+ * table, each Pokedex as its ascending ID array).
+ * @param path file to (atomically) replace
+ * @return 1 once the new file and its directory entry are synced, 0 on failure
+ * Why we made it: State survives the process without replaying menu input.
+ */
+int saveSnapshot(const char *path);
+
+/**
+ * @brief Map a snapshot and append its owners to the ring, building each tree
+ * straight from the sorted IDs with buildBalancedTree (O(n), no rotations).
+ * @param path snapshot file
+ * @return owners loaded, 0 if the file doesn't exist, -1 if it is corrupt
+ * (nothing is kept in that case)
+ * Why we made it: Fast startup for large owner sets.
+ */
+int loadSnapshot(const char *path);
+
+/* ------------------------------------------------------------
+   17) Journal
+   ------------------------------------------------------------ */
+
+typedef enum
+{
+    JOURNAL_CREATE = 1, //owner, starter ID
+    JOURNAL_DELETE,     //owner
+    JOURNAL_ADD,        //owner, ID
+    JOURNAL_RELEASE,    //owner, ID
+    JOURNAL_EVOLVE,     //owner, ID
+    JOURNAL_MERGE,      //owner, merged-away owner
+    JOURNAL_SORT,
+    JOURNAL_STORAGE     //owner, StorageMode
+} JournalOp;
+
+/**
+ * @brief Replay an existing journal onto the current owners, drop a torn tail,
+ * and keep the file open for appending.
+ * @param path journal file (created if missing)
+ * @return records replayed, or -1 if the file can't be used
+ * Why we made it: Changes made after the last snapshot survive a crash.
+ */
+int journalOpen(const char *path);
+
+/**
+ * @brief Queue one mutation; it is written once the current group is full.
+ * @param op what happened
+ * @param first owner name (or NULL)
+ * @param second second owner name for merges (or NULL)
+ * @param arg Pokemon ID / starter ID / storage mode
+ * Why we made it: Called by every mutating menu function and batch command.
+ */
+void journalRecord(JournalOp op, const char *first, const char *second, int arg);
+
+/**
+ * @brief Write all queued records with one write and one fsync.
+ * Why we made it: Group commit keeps scripted workloads from syncing per record.
+ */
+void journalCommit(void);
+
+/**
+ * @brief Empty the journal (queued records included) after a checkpoint.
+ * Why we made it: The snapshot now holds everything the journal did.
+ */
+void journalTruncate(void);
+
+/**
+ * @brief Commit what is queued and close the journal.
+ * Why we made it: Clean shutdown.
+ */
+void journalClose(void);
+
+/**
+ * @brief Save a snapshot; if it is the --snapshot file, truncate the journal.
+ * @param path snapshot file
+ * @return 1 on success, 0 on failure
+ * Why we made it: A checkpoint is a snapshot plus an empty journal.
+ */
+int checkpointSnapshot(const char *path);
+
+/* ------------------------------------------------------------
+   18) Statistics
+   ------------------------------------------------------------ */
+
+/**
+ * @brief Count one tree search/insert/remove and track its depth.
+ * @param op which operation
+ * @param depth nodes visited by this call
+ * Why we made it: Shows whether trees stay shallow under real load.
+ */
+void recordTreeOp(TreeOp op, int depth);
+
+/**
+ * @brief Start timing a menu action or batch command.
+ * @param timer caller-owned snapshot of the counters
+ * Why we made it: Pairs with actionEnd.
+ */
+void actionStart(ActionTimer *timer);
+
+/**
+ * @brief Add the action's latency (input waits excluded) and allocations to its stats.
+ * @param timer the snapshot taken by actionStart
+ * @param action which action ran
+ * Why we made it: Per-action latency histograms without an external profiler.
+ */
+void actionEnd(ActionTimer *timer, MenuAction action);
+
+/**
+ * @brief Print every counter and histogram.
+ * @param out stdout for the menu entry, stderr for the --stats dump at exit
+ * Why we made it: The "Statistics" main-menu entry and --stats.
+ */
+void printStatistics(FILE *out);
+
+/**
+ * @brief Live bytes per subsystem, high-water marks, and (at exit) every block
+ * still allocated, grouped by the ex6.c line that allocated it.
+ * @param out where to print
+ * @param listBlocks also list unfreed blocks by call site
+ * Why we made it: Leak checks and memory growth without valgrind's slowdown.
+ * Only built with -DTRACK_ALLOC.
+ */
+#if defined(TRACK_ALLOC)
+void memoryReport(FILE *out, int listBlocks);
+#endif
+
 // Array of Pokemon data
 static const PokemonData pokedex[] = {
     {1, "Bulbasaur", GRASS, 45, 49, CAN_EVOLVE},